@@ -27,6 +27,13 @@
 
 #include <math.h>       // trig fcns
 #include <memory.h>     // memcpy
+#include <stdio.h>      // tuning profiles
+#include <string.h>     // strcmp
+#include <time.h>       // clock
+
+#ifdef SE_SSE
+#include <xmmintrin.h>  // streaming stores
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -63,6 +70,373 @@ typedef struct {
     seFloat x, y, z;
 } seVec3;
 
+typedef struct {
+    seFloat x, y, z, w;
+} seQuat;
+
+typedef struct {
+    seQuat q;
+    seVec3 t;
+} seRigid;
+
+/* 
+ * seRigids:
+ * SoA streams of rigid transforms, one float stream per component.
+ * 
+ */
+typedef struct {
+    seFloat *qx, *qy, *qz, *qw;
+    seFloat *tx, *ty, *tz;
+} seRigids;
+
+/* SoA streams of vectors and quaternions */
+typedef struct {
+    seFloat *x, *y, *z;
+} seVec3s;
+
+typedef struct {
+    seFloat *x, *y, *z, *w;
+} seQuats;
+
+/* 
+ * Euler angle orders, named after the axes in the order their rotations
+ * are multiplied: SE_EULER_XYZ is Rx * Ry * Rz, as in seM4RotateEuler.
+ * Euler angles are passed in a seVec3 in that same order, in degrees.
+ * 
+ */
+#define SE_EULER(i, j, k) (((i) << 4) | ((j) << 2) | (k))
+enum {
+    SE_EULER_XYZ = SE_EULER(0, 1, 2),
+    SE_EULER_XZY = SE_EULER(0, 2, 1),
+    SE_EULER_YXZ = SE_EULER(1, 0, 2),
+    SE_EULER_YZX = SE_EULER(1, 2, 0),
+    SE_EULER_ZXY = SE_EULER(2, 0, 1),
+    SE_EULER_ZYX = SE_EULER(2, 1, 0),
+    SE_EULER_XYX = SE_EULER(0, 1, 0),
+    SE_EULER_XZX = SE_EULER(0, 2, 0),
+    SE_EULER_YXY = SE_EULER(1, 0, 1),
+    SE_EULER_YZY = SE_EULER(1, 2, 1),
+    SE_EULER_ZXZ = SE_EULER(2, 0, 2),
+    SE_EULER_ZYZ = SE_EULER(2, 1, 2)
+};
+
+typedef struct {
+    seVec3 center;
+    seVec3 axis[3];     // orthonormal box axes
+    seVec3 extent;      // half-widths along each axis
+} seOBB;
+
+/* 
+ * seBVH:
+ * A bounding volume hierarchy over the triangles of an indexed mesh,
+ * built into caller-provided node and order arrays. Leaves have leaf
+ * set and list count triangles starting at order[first]; interior
+ * nodes have their children at first and first + 1. An empty mesh
+ * builds no nodes.
+ * 
+ */
+typedef struct {
+    seVec3 min, max;
+    int first, count;
+    int leaf;
+} seBVHNode;
+
+typedef struct {
+    const seVec3 *v;
+    const unsigned int *index;
+    seBVHNode *nodes;
+    unsigned int *order;
+    int count;          // nodes in use
+} seBVH;
+
+/* Returned by the se*Filter predicates when rounding leaves the sign open */
+#define SE_SIGN_UNSURE 2
+
+/* Doubles of scratch seInSphereExact needs */
+#define SE_INSPHERE_SCRATCH 14496
+
+/* 
+ * seTransforms:
+ * Dense SoA storage of translation, rotation and scale with a world
+ * matrix per transform, addressed through generational handles (see
+ * seTransformsAdd). Live transforms always occupy positions 0..count-1.
+ * 
+ */
+typedef unsigned long long seHandle;
+
+#define SE_HANDLE_NONE 0
+#ifndef SE_HANDLE_INDEX_BITS
+#define SE_HANDLE_INDEX_BITS 32     // the generation takes the bits above
+#endif
+#define SE_HANDLE_INDEX_MASK ((1ull << SE_HANDLE_INDEX_BITS) - 1)
+#define SE_HANDLE_GENERATION_MAX (~0ull >> SE_HANDLE_INDEX_BITS)
+#define SE_TRANSFORM_CHUNK 16       // transforms per chunk, 64 bytes of floats
+
+typedef struct {
+    seVec3s position;
+    seQuats rotation;
+    seVec3s scale;
+    seMat4 *world;
+    seHandle *handle;           // per position: handle of the transform there
+    seHandle *generation;       // per handle index
+    unsigned int *slot;         // per handle index: position, or next free
+    int count, capacity;
+    int slots;                  // handle indices available
+    int used;                   // handle indices ever handed out
+    int free, freeLast;         // oldest and newest free handle index, or -1
+} seTransforms;
+
+/* 
+ * seM4Set:
+ * A hash set of distinct matrices over caller-owned storage, for
+ * deduplicating instance transforms (see seM4SetInsertBatch).
+ * 
+ */
+typedef struct {
+    unsigned int *table;    // 2 * size: hash and unique index + 1 per slot
+    int size;               // table slots, a power of two
+    seMat4 *unique;         // distinct matrices in first-seen order
+    int count, capacity;    // distinct matrices stored, and room for
+    int inserted;           // matrices inserted since the last clear
+    size_t saved;           // bytes of duplicates not stored
+} seM4Set;
+
+/* 
+ * seMorphTarget:
+ * A sparse morph target: the vertices it moves and their position and
+ * (optionally) normal deltas, as parallel arrays.
+ * 
+ */
+typedef struct {
+    const unsigned int *index;          // vertices moved
+    const seFloat *dx, *dy, *dz;        // position deltas
+    const seFloat *nx, *ny, *nz;        // normal deltas, or all NULL
+    int count;
+} seMorphTarget;
+
+/* Noise kinds for seNoiseParams */
+enum {
+    SE_NOISE_PERLIN,
+    SE_NOISE_SIMPLEX
+};
+
+/* 
+ * seNoiseParams:
+ * A fractal noise field evaluated by seFractal and its batch forms.
+ * 
+ */
+typedef struct {
+    int kind;               // SE_NOISE_PERLIN or SE_NOISE_SIMPLEX
+    int octaves;
+    int ridged;             // nonzero for ridged instead of plain fBm
+    seFloat frequency;      // of the first octave
+    seFloat lacunarity;     // frequency ratio between octaves, often 2
+    seFloat gain;           // amplitude ratio between octaves, often 0.5
+    unsigned int seed;
+} seNoiseParams;
+
+typedef struct {
+    seFloat volume, mass;
+    seVec3 centroid;
+    seMat3 inertia;     // about the centroid
+} seMassProperties;
+
+/* Matrix layouts for seInstanceBuild* output */
+enum {
+    SE_LAYOUT_ROW_MAJOR,        // tightly packed rows, as seMat4 stores them
+    SE_LAYOUT_COLUMN_MAJOR,     // tightly packed columns, no GL transpose needed
+    SE_LAYOUT_STD140            // columns padded to vec4, also valid for std430
+};
+
+/* Matrices written per instance by seInstanceBuild* */
+#define SE_INSTANCE_MODEL  1    // mat4 model matrix
+#define SE_INSTANCE_MVP    2    // mat4 view-projection * model
+#define SE_INSTANCE_NORMAL 4    // mat3 inverse transpose of the model rotation
+#define SE_INSTANCE_STREAM 8    // write with non-temporal stores (SE_SSE only)
+
+/* Store modes for seV3TransformM4Stream */
+enum {
+    SE_STORE_AUTO,              // ask seTuningStoreMode
+    SE_STORE_CACHED,            // ordinary stores
+    SE_STORE_STREAM             // non-temporal stores that bypass the cache
+};
+
+/* 
+ * seTuning:
+ * A per-machine profile measured by seTune: the faster store mode for
+ * each size class of point transform (see seTuneClass), and the chunk
+ * size to split pipelined batch work into. Point seTuningActive at one
+ * to have the library use it.
+ * 
+ */
+#define SE_TUNE_CLASSES 8
+#define SE_TUNING_VERSION 1
+
+typedef struct {
+    int store[SE_TUNE_CLASSES];     // SE_STORE_CACHED or SE_STORE_STREAM
+    int chunk;                      // elements per work item
+} seTuning;
+
+/* 
+ * seCursor:
+ * Progress through a batch job that is run a budgeted slice at a time,
+ * e.g. a little every frame (see seCursorNext).
+ * 
+ */
+typedef struct {
+    int next;           // first element not yet handed out
+    int count;          // elements in the job
+    int budget;         // elements left in the current slice
+    double deadline;    // SE_NOW() by which the current slice must end
+} seCursor;
+
+/* Space-filling curves for seSpatialKeys */
+enum {
+    SE_CURVE_MORTON,            // Z-order, cheapest to compute
+    SE_CURVE_HILBERT            // no jumps between consecutive cells
+};
+
+typedef struct {
+    seVec3 n;
+    seFloat d;      // n . p + d is zero on the plane, positive in front
+} sePlane;
+
+/* 
+ * seCullCache:
+ * Per-object culling results kept between frames by
+ * seCullSpheresCoherent, over arrays the caller owns.
+ * 
+ */
+typedef struct {
+    signed char *plane;     // per object: plane that culled it, or -1
+    seFloat *expiry;        // per object: drift at which its result lapses
+    sePlane planes[6];      // planes of the last call
+    double drift;           // how far any plane may have moved since the last rebase
+    seFloat radius;         // bound on object distance from the origin
+    int count;
+    int tested, reused;     // objects tested and reused by the last call
+} seCullCache;
+
+/* 
+ * seIKChains:
+ * A batch of kinematic chains that share a joint count, stored as
+ * joint-major streams: joint j of chain c lives at [j * stride + c], so
+ * the same joint of neighbouring chains is contiguous. Per-chain root
+ * and target streams are indexed by chain alone.
+ * 
+ * Joint 0 sits at the root. The offset of joint j (j > 0) is measured
+ * from joint j - 1 in the frame of joint j - 1, and the world rotation
+ * of joint j is root * q[0] * ... * q[j]. The last joint is the end
+ * effector; its rotation is never touched by the solvers.
+ * 
+ */
+typedef struct {
+    int count;                  // chains to solve
+    int stride;                 // distance between joints of one chain
+    int joints;                 // joints per chain, end effector included
+    seFloat *qx, *qy, *qz, *qw; // local joint rotations (in/out)
+    const seFloat *ox, *oy, *oz;                // joint offsets
+    const seFloat *limit;       // max angle per joint in degrees, or NULL
+    const seFloat *rootX, *rootY, *rootZ;
+    const seFloat *rootQX, *rootQY, *rootQZ, *rootQW;
+    const seFloat *targetX, *targetY, *targetZ;
+} seIKChains;
+
+/* 
+ * seDHLink:
+ * One link of a Denavit-Hartenberg kinematic chain. The joint variable
+ * is added to theta for revolute joints and to d for prismatic ones.
+ * Angles are in degrees.
+ * 
+ */
+typedef struct {
+    seFloat a, alpha, d, theta;
+    int prismatic;
+} seDHLink;
+
+/* 
+ * seClusterGrid:
+ * A view frustum split into width x height screen tiles and depth
+ * slices spaced exponentially between the near and far planes. The
+ * projection parameters match those of seM4Perspective.
+ * 
+ */
+typedef struct {
+    int width, height, depth;
+    seFloat angle, ratio, near, far;
+    seMat4 view;
+} seClusterGrid;
+
+/* 
+ * seLights:
+ * Point and spot lights as SoA streams. Spot lights also carry a
+ * direction and a half-angle in degrees; lights with no direction
+ * stream, or a half-angle of 90 degrees or more, are point lights.
+ * 
+ */
+typedef struct {
+    int count;
+    const seFloat *x, *y, *z, *radius;
+    const seFloat *dx, *dy, *dz, *angle;
+} seLights;
+
+/* Derived data cached by seCamera */
+enum {
+    SE_CAMERA_VIEW,
+    SE_CAMERA_PROJECTION,
+    SE_CAMERA_VIEW_PROJECTION,
+    SE_CAMERA_INVERSE_VIEW,
+    SE_CAMERA_INVERSE_PROJECTION,
+    SE_CAMERA_INVERSE_VIEW_PROJECTION,
+    SE_CAMERA_FRUSTUM,
+    SE_CAMERA_CACHED
+};
+
+/* 
+ * seCamera:
+ * A look-at camera with a perspective projection. Use the setters to
+ * change its parameters; each one bumps a version counter, and derived
+ * matrices and frustum planes are rebuilt on the next read only if the
+ * versions they were built from are stale.
+ * 
+ */
+typedef struct {
+    seVec3 eye, center, up;
+    seFloat angle, ratio, near, far;
+    unsigned int viewVersion, projectionVersion;
+    unsigned int stamp[SE_CAMERA_CACHED][2];
+    seMat4 view, projection, viewProjection;
+    seMat4 inverseView, inverseProjection, inverseViewProjection;
+    sePlane frustum[6];     // left, right, bottom, top, near, far
+} seCamera;
+
+/* 
+ * seTrace:
+ * A caller-owned buffer that seTraceRecord appends calls to, for
+ * replaying a real session's mix of calls with seTraceReplay.
+ * 
+ */
+typedef struct {
+    unsigned char *data;
+    size_t size;        // capacity of data in bytes
+    size_t used;
+    int dropped;        // calls that did not fit
+} seTrace;
+
+/* Calls recorded by seTrace* */
+enum {
+    SE_TRACE_V3NORMALIZE = 1,
+    SE_TRACE_V3CROSS,
+    SE_TRACE_V3TRANSFORMM4,
+    SE_TRACE_M4MULTIPLY,
+    SE_TRACE_M4PERSPECTIVE,
+    SE_TRACE_M4LOOKAT,
+    SE_TRACE_M4INVERSE,
+    SE_TRACE_QMULTIPLY,
+    SE_TRACE_QSLERP,
+    SE_TRACE_M4FROMQ
+};
+
 
 /** PROTOTYPES ********************************************************/
 
@@ -85,9 +459,265 @@ seMat4 seM4LookAt(seVec3 eye, seVec3 center, seVec3 up);
 seMat4 seM4Identity();
 seMat4 seM4Scale(seFloat x, seFloat y, seFloat z);
 seMat4 seM4Translate(seFloat x, seFloat y, seFloat z);
-seMat4 seM4Rotate(seFloat x, seFloat y, seFloat z);
-seMat4 seM4RotateEuler(seVec3 v);
+seMat4 seM4RotateEuler(seFloat x, seFloat y, seFloat z);
+seMat4 seM4RotateEulerV3(seVec3 v);
 seMat4 seM4RotateAA(seVec3 v, const seFloat t);
+seMat4 seM4Transpose(seMat4 m);
+seMat4 seM4Inverse(seMat4 m);
+void seM4Frustum(seMat4 m, sePlane *planes);
+seFloat seM4OrthoError(seMat4 m);
+seMat4 seM4Orthonormalize(seMat4 m);
+seMat4 seM4OrthonormalizePolar(seMat4 m, int iterations);
+int seM4OrthonormalizeBatch(seMat4 *m, int count, seFloat tolerance, int iterations);
+
+/* Batch Operations */
+seVec3 seV3TransformM4(seMat4 m, seVec3 v);
+int seMaskCompress(const unsigned int *mask, int count, unsigned int *index);
+void seV3TransformM4Batch(seMat4 m, seVec3s in, seVec3s out, int count);
+void seV3TransformM4Stream(seMat4 m, seVec3s in, seVec3s out, int count, int mode);
+void seV3TransformM4Indexed(seMat4 m, seVec3s in, seVec3s out, const unsigned int *index, int count);
+void seV3NormalizeBatch(seVec3s in, seVec3s out, int count);
+void seV3NormalizeIndexed(seVec3s in, seVec3s out, const unsigned int *index, int count);
+seFloat seFastRsqrt(seFloat x);
+void seV3NormalizeFastBatch(seVec3s in, seVec3s out, int count);
+void seM4MultiplyBatch(const seMat4 *a, const seMat4 *b, seMat4 *out, int count);
+void seM4MultiplyIndexed(const seMat4 *a, const seMat4 *b, seMat4 *out, const unsigned int *index, int count);
+
+/* Batch Partitioning */
+void seBatchRange(int count, int elementSize, int parts, int part, int *first, int *n);
+
+/* Autotuning */
+int seTuneClass(int count);
+void seTuningDefault(seTuning *t);
+double seTuneRun(seVec3s in, seVec3s out, int count, int mode, int chunk);
+void seTune(seTuning *t, seFloat *scratch, size_t floats);
+int seTuningStoreMode(const seTuning *t, int count);
+int seTuningSave(const seTuning *t, const char *path);
+int seTuningLoad(seTuning *t, const char *path);
+
+/* Resumable Batches */
+void seCursorInit(seCursor *c, int count);
+void seCursorBudget(seCursor *c, int elements, double seconds);
+int seCursorNext(seCursor *c, int *first);
+int seCursorDone(const seCursor *c);
+int seM4OrthonormalizeResume(seMat4 *m, seCursor *c, seFloat tolerance, int iterations);
+void seQFromM4Resume(const seMat4 *m, seQuats out, seCursor *c);
+void seV3TransformM4Resume(seMat4 m, seVec3s in, seVec3s out, seCursor *c);
+
+/* Quaternions */
+seQuat seQAssign(seFloat x, seFloat y, seFloat z, seFloat w);
+seQuat seQIdentity();
+seQuat seQMultiply(seQuat q1, seQuat q2);
+seQuat seQConjugate(seQuat q);
+seQuat seQNormalize(seQuat q);
+seQuat seQFromAA(seVec3 v, const seFloat t);
+seQuat seQFromTo(seVec3 from, seVec3 to);
+seQuat seQClampAngle(seQuat q, const seFloat t);
+seVec3 seV3RotateQ(seQuat q, seVec3 v);
+seQuat seQSlerp(seQuat q1, seQuat q2, const seFloat t);
+seMat4 seM4FromQ(seQuat q);
+
+/* Rotation Conversions */
+seQuat seQFromM4(seMat4 m);
+seQuat seQFromEuler(seVec3 v, int order);
+seMat4 seM4FromEuler(seVec3 v, int order);
+seVec3 seM4ToEuler(seMat4 m, int order);
+seVec3 seQToEuler(seQuat q, int order);
+seFloat seQToAA(seQuat q, seVec3 *axis);
+void seQFromEulerBatch(seVec3s v, int order, seQuats out, int count);
+void seQToEulerBatch(seQuats q, int order, seVec3s out, int count);
+void seM4FromEulerBatch(seVec3s v, int order, seMat4 *out, int count);
+void seM4ToEulerBatch(const seMat4 *m, int order, seVec3s out, int count);
+void seQFromM4Batch(const seMat4 *m, seQuats out, int count);
+void seM4FromQBatch(seQuats q, seMat4 *out, int count);
+void seQFromAABatch(seVec3s axis, const seFloat *angle, seQuats out, int count);
+void seQToAABatch(seQuats q, seVec3s axis, seFloat *angle, int count);
+
+/* Rigid Transforms */
+seRigid seRAssign(seQuat q, seVec3 t);
+seRigid seRIdentity();
+seRigid seRMultiply(seRigid r1, seRigid r2);
+seRigid seRInverse(seRigid r);
+seRigid seRInterpolate(seRigid r1, seRigid r2, const seFloat t);
+seVec3 seV3TransformR(seRigid r, seVec3 v);
+seMat4 seM4FromR(seRigid r);
+seRigid seRLoad(seRigids r, int i);
+void seRStore(seRigids r, int i, seRigid v);
+void seRMultiplyBatch(seRigids a, seRigids b, seRigids out, int count);
+void seRInverseBatch(seRigids r, seRigids out, int count);
+void seV3TransformRBatch(seRigids r, const seFloat *x, const seFloat *y, const seFloat *z, seFloat *ox, seFloat *oy, seFloat *oz, int count);
+void seM4FromRBatch(seRigids r, int count, seMat4 *out);
+void seRMultiplyIndexed(seRigids a, seRigids b, seRigids out, const unsigned int *index, int count);
+void seV3TransformRIndexed(seRigids r, seVec3s in, seVec3s out, const unsigned int *index, int count);
+
+/* Instance Buffers */
+int seInstanceStride(int flags, int layout);
+seMat4 seM4FromTRS(seVec3 t, seQuat r, seVec3 s);
+seFloat *seInstanceWrite(seMat4 model, seVec3 scale, const seMat4 *viewProjection, int flags, int layout, seFloat *out);
+seFloat *seInstanceCopy(const seFloat *stage, int n, int stream, seFloat *out);
+void seInstanceBuildTRS(seVec3s t, seQuats r, seVec3s s, seMat4 viewProjection, int flags, int layout, int count, seFloat *out);
+void seInstanceBuildR(seRigids r, seMat4 viewProjection, int flags, int layout, int count, seFloat *out);
+
+/* Transform Storage */
+size_t seTransformsBytes(int capacity);
+void seTransformsInit(seTransforms *ts, void *memory, int capacity);
+seHandle seTransformsAdd(seTransforms *ts, seVec3 position, seQuat rotation, seVec3 scale);
+int seTransformsIndex(const seTransforms *ts, seHandle h);
+int seTransformsRemove(seTransforms *ts, seHandle h);
+int seTransformsChunk(const seTransforms *ts, int k, int *first);
+void seTransformsUpdate(seTransforms *ts, seMat4 parent, int first, int count);
+
+/* Hashing and Deduplication */
+unsigned int seHashWords(const unsigned int *w, int count, unsigned int seed);
+unsigned int seM4Hash(const seMat4 *m);
+unsigned int seV3Hash(seVec3 v);
+void seM4HashBatch(const seMat4 *m, unsigned int *hash, int count);
+void seM4SetInit(seM4Set *set, unsigned int *table, int size, seMat4 *unique, int capacity);
+void seM4SetClear(seM4Set *set);
+int seM4SetInsert(seM4Set *set, const seMat4 *m, unsigned int hash);
+int seM4SetInsertBatch(seM4Set *set, const seMat4 *m, const unsigned int *hash, unsigned int *remap, int count);
+
+/* Morph Targets */
+void seMorphAdd(seVec3s out, const unsigned int *index, const seFloat *dx, const seFloat *dy, const seFloat *dz, seFloat w, int count);
+void seMorphBlend(seVec3s base, seVec3s baseNrm, const seMorphTarget *targets, const seFloat *weights, int targetCount, seFloat threshold, seVec3s pos, seVec3s nrm, int vertices);
+
+/* Noise */
+unsigned int seNoiseHash(unsigned int h, int i);
+void seNoiseGradient(unsigned int h, int dims, seFloat *g);
+seFloat sePerlin(const seFloat *p, int dims, unsigned int seed, seFloat *gradient);
+seFloat seSimplex(const seFloat *p, int dims, unsigned int seed, seFloat *gradient);
+seFloat sePerlin3(seVec3 p, unsigned int seed, seVec3 *gradient);
+seFloat seSimplex3(seVec3 p, unsigned int seed, seVec3 *gradient);
+seFloat seNoiseDot3(unsigned int h, seFloat x, seFloat y, seFloat z);
+void sePerlin3Batch(seVec3s p, unsigned int seed, seFloat *out, int count);
+seFloat seSimplex3Corner(unsigned int seed, int cx, int cy, int cz, seFloat x, seFloat y, seFloat z);
+void seSimplex3Batch(seVec3s p, unsigned int seed, seFloat *out, int count);
+seFloat seFractal(const seNoiseParams *np, const seFloat *p, int dims, seFloat *gradient);
+void seFractal3Batch(const seNoiseParams *np, seVec3s p, seFloat *out, seVec3s gradient, int count);
+void seFractalGrid3(const seNoiseParams *np, seVec3 origin, seVec3 spacing, int nx, int ny, int first, int count, seFloat *out);
+
+/* Mass Properties */
+int seMeshMassBlocks(int triangles);
+void seMeshMassPartial(const seVec3 *v, const unsigned int *index, int triangles, int block, double *sums);
+seMassProperties seMeshMassReduce(const double *sums, int blocks, seFloat density);
+seMassProperties seMeshMass(const seVec3 *v, const unsigned int *index, int triangles, seFloat density);
+
+/* Closest Points */
+seVec3 seV3ClosestSegment(seVec3 p, seVec3 a, seVec3 b, seFloat *t);
+seVec3 seV3ClosestTriangle(seVec3 p, seVec3 a, seVec3 b, seVec3 c, seVec3 *bary);
+seVec3 seV3ClosestOBB(seVec3 p, const seOBB *box);
+void seV3ClosestSegmentBatch(seVec3s p, seVec3 a, seVec3 b, seVec3s out, seFloat *distance, int count);
+void seV3ClosestTriangleBatch(seVec3s p, seVec3 a, seVec3 b, seVec3 c, seVec3s out, seFloat *distance, int count);
+void seV3ClosestOBBBatch(seVec3s p, const seOBB *box, seVec3s out, seFloat *distance, int count);
+int seBVHBuild(seBVH *bvh, const seVec3 *v, const unsigned int *index, int triangles, seBVHNode *nodes, unsigned int *order);
+void seBVHSplit(seBVH *bvh, int n, int first, int count);
+seFloat seBVHBoxDistance(const seBVHNode *node, seVec3 p);
+int seBVHClosest(const seBVH *bvh, seVec3 p, seFloat maxDistance, seVec3 *point, seVec3 *bary, seFloat *distance);
+
+/* Robust Predicates */
+int seExpSum(const double *e, int elen, const double *f, int flen, double *h);
+int seExpScale(const double *e, int elen, double b, double *h);
+int seExpCross(double ax, double ay, double bx, double by, double *h);
+int seExpOrient2D(seVec3 p, seVec3 q, seVec3 r, double *h);
+int seExpOrient3D(seVec3 p, seVec3 q, seVec3 r, seVec3 s, double *h);
+int seExpLift(const double *e, int elen, seVec3 p, int dims, double sign, double *h, double *work);
+int seOrient2DExact(seVec3 a, seVec3 b, seVec3 c);
+int seOrient3DExact(seVec3 a, seVec3 b, seVec3 c, seVec3 d);
+int seInCircleExact(seVec3 a, seVec3 b, seVec3 c, seVec3 d);
+int seInSphereExact(seVec3 a, seVec3 b, seVec3 c, seVec3 d, seVec3 e, double *scratch);
+int seOrient2DFilter(seVec3 a, seVec3 b, seVec3 c);
+int seOrient3DFilter(seVec3 a, seVec3 b, seVec3 c, seVec3 d);
+int seInCircleFilter(seVec3 a, seVec3 b, seVec3 c, seVec3 d);
+int seInSphereFilter(seVec3 a, seVec3 b, seVec3 c, seVec3 d, seVec3 e);
+int seOrient2D(seVec3 a, seVec3 b, seVec3 c);
+int seOrient3D(seVec3 a, seVec3 b, seVec3 c, seVec3 d);
+int seInCircle(seVec3 a, seVec3 b, seVec3 c, seVec3 d);
+int seInSphere(seVec3 a, seVec3 b, seVec3 c, seVec3 d, seVec3 e, double *scratch);
+void seOrient2DBatch(seVec3 a, seVec3 b, seVec3s c, int *sign, int count);
+void seOrient3DBatch(seVec3 a, seVec3 b, seVec3 c, seVec3s d, int *sign, int count);
+void seInCircleBatch(seVec3 a, seVec3 b, seVec3 c, seVec3s d, int *sign, int count);
+void seInSphereBatch(seVec3 a, seVec3 b, seVec3 c, seVec3 d, seVec3s e, int *sign, int count, double *scratch);
+
+/* Mesh Optimization */
+int seMeshCacheStats(const unsigned int *index, int triangles, int vertices, int cacheSize, unsigned int *scratch, seFloat *acmr, seFloat *atvr);
+int seMeshOptimizeCacheScratch(int triangles, int vertices);
+int seMeshOptimizeCache(const unsigned int *index, int triangles, int vertices, int cacheSize, unsigned int *out, unsigned int *clusters, unsigned int *scratch);
+int seMeshClusterSplit(const unsigned int *index, int triangles, int vertices, const unsigned int *clusters, int clusterCount, int cacheSize, seFloat threshold, unsigned int *out, unsigned int *scratch);
+void seMeshOptimizeOverdraw(const unsigned int *index, int triangles, const seVec3 *v, const unsigned int *clusters, int clusterCount, const seVec3 *views, int viewCount, unsigned int *out, seFloat *keys, unsigned int *scratch);
+int seMeshOptimizeFetch(unsigned int *index, int triangles, int vertices, unsigned int *remap);
+void seMeshRemapV3(const seVec3 *v, const unsigned int *remap, int vertices, seVec3 *out);
+void seMeshRemap(const void *in, const unsigned int *remap, int vertices, int stride, void *out);
+
+/* Depth Sorting */
+void seV3ViewDepths(seMat4 view, const seFloat *x, const seFloat *y, const seFloat *z, int count, seFloat *depth);
+void seSortKeys(unsigned int *keys, int count, unsigned int *perm, unsigned int *scratch);
+void seSortHistogram(const unsigned int *keys, int first, int last, int pass, unsigned int *hist);
+int seSortPrefix(unsigned int *hist, int slices);
+void seSortScatter(const unsigned int *keys, const unsigned int *perm, int first, int last, int pass, unsigned int *hist, unsigned int *outKeys, unsigned int *outPerm);
+void seSortDepthKeys(const seFloat *depth, int count, int backToFront, unsigned int *keys);
+void seSortDepths(const seFloat *depth, int count, int backToFront, unsigned int *perm, unsigned int *scratch);
+
+/* Spatial Ordering */
+unsigned int seMorton3(unsigned int x, unsigned int y, unsigned int z);
+unsigned int seHilbert3(unsigned int x, unsigned int y, unsigned int z);
+void seV3BoundsBatch(seVec3s p, int count, seVec3 *lo, seVec3 *hi);
+void seSpatialKeys(seVec3s p, seVec3 lo, seVec3 hi, int curve, unsigned int *keys, int count);
+void seSpatialOrder(seVec3s p, int count, int curve, unsigned int *perm, unsigned int *scratch);
+void sePermute(const unsigned int *perm, int count, void *const *streams, const int *strides, int streamCount, unsigned int *scratch);
+
+/* Cameras */
+void seCameraInit(seCamera *cam);
+void seCameraLookAt(seCamera *cam, seVec3 eye, seVec3 center, seVec3 up);
+void seCameraPerspective(seCamera *cam, seFloat angle, seFloat ratio, seFloat near, seFloat far);
+void seCameraUpdate(seCamera *cam);
+const seMat4 *seCameraView(seCamera *cam);
+const seMat4 *seCameraProjection(seCamera *cam);
+const seMat4 *seCameraViewProjection(seCamera *cam);
+const seMat4 *seCameraInverseView(seCamera *cam);
+const seMat4 *seCameraInverseProjection(seCamera *cam);
+const seMat4 *seCameraInverseViewProjection(seCamera *cam);
+const sePlane *seCameraFrustum(seCamera *cam);
+
+/* Frustum Culling */
+int seSphereVisible(const sePlane *planes, seVec3 c, seFloat r);
+void seCullSpheres(const sePlane *planes, seVec3s center, const seFloat *radius, unsigned int *visible, int count);
+void seCullCacheInit(seCullCache *cache, signed char *plane, seFloat *expiry, int count, seFloat radius);
+void seCullSpheresCoherent(seCullCache *cache, const sePlane *planes, seVec3s center, const seFloat *radius, const seFloat *moved, unsigned int *visible);
+
+/* Forward Kinematics */
+seMat4 seM4DH(seDHLink link, seFloat q);
+seMat4 seDHForward(const seDHLink *links, int count, const seFloat *q);
+void seDHForwardBatch(const seDHLink *links, int count, const seFloat *q, int stride, int configs, seMat4 *effector, seMat4 *frames);
+
+/* Light Clusters */
+void seClusterBounds(const seClusterGrid *g, int x, int y, int z, seVec3 *min, seVec3 *max);
+void seClusterSpheres(const seClusterGrid *g, const seLights *lights, seFloat *spheres);
+void seClusterAssign(const seClusterGrid *g, const seFloat *spheres, int lights, int first, int last, unsigned int *grid, unsigned int *indices);
+unsigned int seClusterOffsets(const seClusterGrid *g, unsigned int *grid);
+
+/* Inverse Kinematics */
+int seIKScratchSize(int count, int joints);
+void seIKForward(const seIKChains *ik, seFloat *scratch, int first);
+int seIKConverge(const seIKChains *ik, seFloat *scratch, seFloat tolerance);
+void seIKApply(seIKChains *ik, const seFloat *scratch, int j, int c, seQuat turn);
+int seIKSolveCCD(seIKChains *ik, seFloat *scratch, int iterations, seFloat tolerance);
+int seIKSolveFABRIK(seIKChains *ik, seFloat *scratch, int iterations, seFloat tolerance);
+int seIKSolveDLS(seIKChains *ik, seFloat *scratch, int iterations, seFloat tolerance, seFloat damping);
+
+/* Call Tracing */
+int seTraceArgs(int op);
+void seTraceRecord(seTrace *t, int op, const seFloat *args);
+seVec3 seTraceV3Normalize(seTrace *t, seVec3 v);
+seVec3 seTraceV3Cross(seTrace *t, seVec3 v1, seVec3 v2);
+seVec3 seTraceV3TransformM4(seTrace *t, seMat4 m, seVec3 v);
+seMat4 seTraceM4Multiply(seTrace *t, seMat4 m1, seMat4 m2);
+seMat4 seTraceM4Perspective(seTrace *t, seFloat angle, seFloat ratio, seFloat near, seFloat far);
+seMat4 seTraceM4LookAt(seTrace *t, seVec3 eye, seVec3 center, seVec3 up);
+seMat4 seTraceM4Inverse(seTrace *t, seMat4 m);
+seQuat seTraceQMultiply(seTrace *t, seQuat q1, seQuat q2);
+seQuat seTraceQSlerp(seTrace *t, seQuat q1, seQuat q2, const seFloat s);
+seMat4 seTraceM4FromQ(seTrace *t, seQuat q);
+seFloat seTraceReplay(const unsigned char *data, size_t size, int *calls);
 
 
 /** IMPLEMENTATION ****************************************************/
@@ -410,7 +1040,7 @@ seMat4 seM4RotateEuler(seFloat x, seFloat y, seFloat z)
  */
 seMat4 seM4RotateEulerV3(seVec3 v)
 {
-    return seM4Rotate(v.x, v.y, v.z);
+    return seM4RotateEuler(v.x, v.y, v.z);
 }
 
 /* 
@@ -448,6 +1078,5466 @@ seMat4 seM4RotateAA(seVec3 v, const seFloat t)
     return out;
 }
 
+/* 
+ * seM4Transpose:
+ * Returns the transpose of a 4x4 matrix.
+ * 
+ */
+seMat4 seM4Transpose(seMat4 m)
+{
+    seMat4 out;
+    for (int r = 0; r < 4; r++)
+        for (int c = 0; c < 4; c++)
+            out.e[c * 4 + r] = m.e[r * 4 + c];
+
+    return out;
+}
+
+/* 
+ * seM4Inverse:
+ * Returns the inverse of a 4x4 matrix, or a matrix of zeros if it is
+ * singular.
+ * 
+ */
+seMat4 seM4Inverse(seMat4 m)
+{
+    const seFloat *a = m.e;
+
+    // 2x2 minors of the top and bottom row pairs
+    seFloat s0 = a[0] * a[5]  - a[4]  * a[1];
+    seFloat s1 = a[0] * a[6]  - a[4]  * a[2];
+    seFloat s2 = a[0] * a[7]  - a[4]  * a[3];
+    seFloat s3 = a[1] * a[6]  - a[5]  * a[2];
+    seFloat s4 = a[1] * a[7]  - a[5]  * a[3];
+    seFloat s5 = a[2] * a[7]  - a[6]  * a[3];
+    seFloat c5 = a[10] * a[15] - a[14] * a[11];
+    seFloat c4 = a[9]  * a[15] - a[13] * a[11];
+    seFloat c3 = a[9]  * a[14] - a[13] * a[10];
+    seFloat c2 = a[8]  * a[15] - a[12] * a[11];
+    seFloat c1 = a[8]  * a[14] - a[12] * a[10];
+    seFloat c0 = a[8]  * a[13] - a[12] * a[9];
+
+    seFloat det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+    if (det == 0)
+        return seM4Fill(0);
+    seFloat inv = 1 / det;
+
+    seMat4 out;
+    out.e[0]  = ( a[5]  * c5 - a[6]  * c4 + a[7]  * c3) * inv;
+    out.e[1]  = (-a[1]  * c5 + a[2]  * c4 - a[3]  * c3) * inv;
+    out.e[2]  = ( a[13] * s5 - a[14] * s4 + a[15] * s3) * inv;
+    out.e[3]  = (-a[9]  * s5 + a[10] * s4 - a[11] * s3) * inv;
+    out.e[4]  = (-a[4]  * c5 + a[6]  * c2 - a[7]  * c1) * inv;
+    out.e[5]  = ( a[0]  * c5 - a[2]  * c2 + a[3]  * c1) * inv;
+    out.e[6]  = (-a[12] * s5 + a[14] * s2 - a[15] * s1) * inv;
+    out.e[7]  = ( a[8]  * s5 - a[10] * s2 + a[11] * s1) * inv;
+    out.e[8]  = ( a[4]  * c4 - a[5]  * c2 + a[7]  * c0) * inv;
+    out.e[9]  = (-a[0]  * c4 + a[1]  * c2 - a[3]  * c0) * inv;
+    out.e[10] = ( a[12] * s4 - a[13] * s2 + a[15] * s0) * inv;
+    out.e[11] = (-a[8]  * s4 + a[9]  * s2 - a[11] * s0) * inv;
+    out.e[12] = (-a[4]  * c3 + a[5]  * c1 - a[6]  * c0) * inv;
+    out.e[13] = ( a[0]  * c3 - a[1]  * c1 + a[2]  * c0) * inv;
+    out.e[14] = (-a[12] * s3 + a[13] * s1 - a[14] * s0) * inv;
+    out.e[15] = ( a[8]  * s3 - a[9]  * s1 + a[10] * s0) * inv;
+
+    return out;
+}
+
+/* 
+ * seM4Frustum:
+ * Extracts the six normalized clipping planes (left, right, bottom,
+ * top, near, far) of a projection or view-projection matrix. Plane
+ * normals point into the frustum.
+ * 
+ */
+void seM4Frustum(seMat4 m, sePlane *planes)
+{
+    const seFloat *e = m.e;
+
+    for (int i = 0; i < 6; i++) {
+        const seFloat *row = e + (i / 2) * 4;
+        seFloat sign = (i % 2) ? -1.0f : 1.0f;
+        sePlane p;
+        p.n.x = e[12] + sign * row[0];
+        p.n.y = e[13] + sign * row[1];
+        p.n.z = e[14] + sign * row[2];
+        p.d   = e[15] + sign * row[3];
+
+        seFloat len = seV3Length(p.n);
+        p.n.x /= len;
+        p.n.y /= len;
+        p.n.z /= len;
+        p.d   /= len;
+        planes[i] = p;
+    }
+}
+
+/* 
+ * seM4OrthoError:
+ * Returns how far the rotation block of a 4x4 matrix has drifted from
+ * orthonormal, as the sum of squared entries of R * R^T - I. This is
+ * cheap enough to run on every matrix before deciding to fix it.
+ * 
+ */
+seFloat seM4OrthoError(seMat4 m)
+{
+    const seFloat *e = m.e;
+    seFloat d00 = e[0] * e[0] + e[1] * e[1] + e[2]  * e[2]  - 1;
+    seFloat d11 = e[4] * e[4] + e[5] * e[5] + e[6]  * e[6]  - 1;
+    seFloat d22 = e[8] * e[8] + e[9] * e[9] + e[10] * e[10] - 1;
+    seFloat d01 = e[0] * e[4] + e[1] * e[5] + e[2]  * e[6];
+    seFloat d02 = e[0] * e[8] + e[1] * e[9] + e[2]  * e[10];
+    seFloat d12 = e[4] * e[8] + e[5] * e[9] + e[6]  * e[10];
+
+    return d00 * d00 + d11 * d11 + d22 * d22 + 2 * (d01 * d01 + d02 * d02 + d12 * d12);
+}
+
+/* 
+ * seM4Orthonormalize:
+ * Returns the matrix with its rotation block made orthonormal by
+ * Gram-Schmidt on the rows. The first row keeps its direction, and the
+ * translation is left untouched.
+ * 
+ */
+seMat4 seM4Orthonormalize(seMat4 m)
+{
+    seVec3 r0 = seV3Normalize(seV3Assign(m.e[0], m.e[1], m.e[2]));
+    seVec3 r1 = seV3Assign(m.e[4], m.e[5], m.e[6]);
+    seFloat d = seV3Dot(r0, r1);
+    r1 = seV3Normalize(seV3Assign(r1.x - d * r0.x, r1.y - d * r0.y, r1.z - d * r0.z));
+    seVec3 r2 = seV3Cross(r0, r1);
+
+    m.e[0]  = r0.x;
+    m.e[1]  = r0.y;
+    m.e[2]  = r0.z;
+    m.e[4]  = r1.x;
+    m.e[5]  = r1.y;
+    m.e[6]  = r1.z;
+    m.e[8]  = r2.x;
+    m.e[9]  = r2.y;
+    m.e[10] = r2.z;
+
+    return m;
+}
+
+/* 
+ * seM4OrthonormalizePolar:
+ * Returns the matrix with its rotation block pulled towards the nearest
+ * rotation by Newton-Schulz polar iteration, R = R(3I - R^T R) / 2.
+ * Unlike Gram-Schmidt this spreads the correction evenly over all axes;
+ * for the small drift of accumulated rotations one or two iterations
+ * are enough.
+ * 
+ */
+seMat4 seM4OrthonormalizePolar(seMat4 m, int iterations)
+{
+    seFloat *e = m.e;
+
+    for (int i = 0; i < iterations; i++) {
+        // s = (3I - R^T R) / 2, symmetric
+        seFloat s00 = 1.5f - 0.5f * (e[0] * e[0] + e[4] * e[4] + e[8]  * e[8]);
+        seFloat s11 = 1.5f - 0.5f * (e[1] * e[1] + e[5] * e[5] + e[9]  * e[9]);
+        seFloat s22 = 1.5f - 0.5f * (e[2] * e[2] + e[6] * e[6] + e[10] * e[10]);
+        seFloat s01 = -0.5f * (e[0] * e[1] + e[4] * e[5] + e[8] * e[9]);
+        seFloat s02 = -0.5f * (e[0] * e[2] + e[4] * e[6] + e[8] * e[10]);
+        seFloat s12 = -0.5f * (e[1] * e[2] + e[5] * e[6] + e[9] * e[10]);
+
+        for (int r = 0; r < 12; r += 4) {
+            seFloat a = e[r], b = e[r + 1], c = e[r + 2];
+            e[r]     = a * s00 + b * s01 + c * s02;
+            e[r + 1] = a * s01 + b * s11 + c * s12;
+            e[r + 2] = a * s02 + b * s12 + c * s22;
+        }
+    }
+
+    return m;
+}
+
+/* 
+ * seM4OrthonormalizeBatch:
+ * Re-orthonormalizes the rotation blocks of count matrices in place,
+ * touching only those whose seM4OrthoError exceeds tolerance. Uses the
+ * given number of polar iterations, or Gram-Schmidt if iterations is 0.
+ * Returns the number of matrices that were corrected.
+ * 
+ * This is a scalar loop with a branch per matrix. seMat4 arrays are
+ * stored matrix by matrix, so there are no lanes to blend across, and
+ * since drift is rare, skipping in-tolerance matrices beats correcting
+ * every one branch-free.
+ * 
+ */
+int seM4OrthonormalizeBatch(seMat4 *m, int count, seFloat tolerance, int iterations)
+{
+    int fixed = 0;
+
+    for (int i = 0; i < count; i++) {
+        if (seM4OrthoError(m[i]) <= tolerance)
+            continue;
+
+        if (iterations > 0)
+            m[i] = seM4OrthonormalizePolar(m[i], iterations);
+        else
+            m[i] = seM4Orthonormalize(m[i]);
+        fixed++;
+    }
+
+    return fixed;
+}
+
+/* Batch Operations */
+
+/* 
+ * seV3TransformM4:
+ * Returns a point transformed by a 4x4 affine transformation matrix.
+ * 
+ */
+seVec3 seV3TransformM4(seMat4 m, seVec3 v)
+{
+    seVec3 out;
+    out.x = (m.e[0] * v.x) + (m.e[1] * v.y) + (m.e[2]  * v.z) + m.e[3];
+    out.y = (m.e[4] * v.x) + (m.e[5] * v.y) + (m.e[6]  * v.z) + m.e[7];
+    out.z = (m.e[8] * v.x) + (m.e[9] * v.y) + (m.e[10] * v.z) + m.e[11];
+
+    return out;
+}
+
+/* 
+ * seMaskCompress:
+ * Writes the positions of the set bits among the first count bits of a
+ * bitmask (32 per word, least significant first) to index and returns
+ * how many there are. Empty words are skipped whole, so the cost of the
+ * *Indexed kernels run on the result follows the size of the subset.
+ * 
+ * The *Indexed kernels are scalar gather/scatter loops without a
+ * branch per element; plain C99 has no gather or compress-store to
+ * vectorize them with.
+ * 
+ */
+int seMaskCompress(const unsigned int *mask, int count, unsigned int *index)
+{
+    int n = 0;
+
+    for (int w = 0; w * 32 < count; w++) {
+        unsigned int bits = mask[w];
+        if (count - w * 32 < 32)
+            bits &= (1u << (count - w * 32)) - 1;
+
+        for (unsigned int i = w * 32; bits; i++, bits >>= 1) {
+            index[n] = i;
+            n += bits & 1;
+        }
+    }
+
+    return n;
+}
+
+/* 
+ * seV3TransformM4Batch:
+ * Transforms count points by the same matrix.
+ * 
+ */
+void seV3TransformM4Batch(seMat4 m, seVec3s in, seVec3s out, int count)
+{
+    for (int i = 0; i < count; i++) {
+        seVec3 v = seV3TransformM4(m, seV3Assign(in.x[i], in.y[i], in.z[i]));
+        out.x[i] = v.x;
+        out.y[i] = v.y;
+        out.z[i] = v.z;
+    }
+}
+
+#ifndef SE_LLC_SIZE
+#define SE_LLC_SIZE (32 << 20)
+#endif
+
+#ifndef SE_PREFETCH_DISTANCE
+#define SE_PREFETCH_DISTANCE 256
+#endif
+
+/* 
+ * seV3TransformM4Stream:
+ * Transforms count points by the same matrix like seV3TransformM4Batch,
+ * choosing how the results are stored. SE_STORE_STREAM writes them with
+ * non-temporal stores, which skip the read-for-ownership of each output
+ * line and leave the cache to the data around the call; the input is
+ * prefetched ahead of use. SE_STORE_AUTO takes the mode from
+ * seTuningStoreMode, which without a profile streams only when the
+ * input and output together exceed SE_LLC_SIZE bytes, since output that
+ * fits in the last-level cache is usually read again soon.
+ * 
+ * Streaming needs SE_SSE to be defined and the three output streams to
+ * share their alignment mod 16 bytes; otherwise ordinary stores are
+ * used.
+ * 
+ */
+void seV3TransformM4Stream(seMat4 m, seVec3s in, seVec3s out, int count, int mode)
+{
+    int i = 0;
+
+    if (mode == SE_STORE_AUTO)
+        mode = seTuningStoreMode(NULL, count);
+
+#ifdef SE_SSE
+    size_t align = (size_t)out.x & 15;
+    if (mode == SE_STORE_STREAM && ((size_t)out.y & 15) == align && ((size_t)out.z & 15) == align) {
+        __m128 r[12];
+        for (int k = 0; k < 12; k++)
+            r[k] = _mm_set1_ps(m.e[k]);
+
+        // scalar stores until the outputs reach a 16-byte boundary
+        for (; i < count && ((size_t)(out.x + i) & 15); i++) {
+            seVec3 v = seV3TransformM4(m, seV3Assign(in.x[i], in.y[i], in.z[i]));
+            out.x[i] = v.x;
+            out.y[i] = v.y;
+            out.z[i] = v.z;
+        }
+
+        for (; i + 4 <= count; i += 4) {
+            _mm_prefetch((const char *)(in.x + i) + SE_PREFETCH_DISTANCE, _MM_HINT_NTA);
+            _mm_prefetch((const char *)(in.y + i) + SE_PREFETCH_DISTANCE, _MM_HINT_NTA);
+            _mm_prefetch((const char *)(in.z + i) + SE_PREFETCH_DISTANCE, _MM_HINT_NTA);
+
+            __m128 x = _mm_loadu_ps(in.x + i);
+            __m128 y = _mm_loadu_ps(in.y + i);
+            __m128 z = _mm_loadu_ps(in.z + i);
+            for (int row = 0; row < 3; row++) {
+                __m128 s = _mm_add_ps(_mm_mul_ps(r[4 * row], x), _mm_mul_ps(r[4 * row + 1], y));
+                s = _mm_add_ps(s, _mm_add_ps(_mm_mul_ps(r[4 * row + 2], z), r[4 * row + 3]));
+                _mm_stream_ps((row == 0 ? out.x : row == 1 ? out.y : out.z) + i, s);
+            }
+        }
+
+        // streamed lines must be visible before other threads read them
+        _mm_sfence();
+    }
+#endif
+
+    for (; i < count; i++) {
+        seVec3 v = seV3TransformM4(m, seV3Assign(in.x[i], in.y[i], in.z[i]));
+        out.x[i] = v.x;
+        out.y[i] = v.y;
+        out.z[i] = v.z;
+    }
+}
+
+/* 
+ * seV3TransformM4Indexed:
+ * Transforms only the count points named by index, gathering them from
+ * in and scattering the results to the same positions of out.
+ * 
+ */
+void seV3TransformM4Indexed(seMat4 m, seVec3s in, seVec3s out, const unsigned int *index, int count)
+{
+    for (int n = 0; n < count; n++) {
+        unsigned int i = index[n];
+        seVec3 v = seV3TransformM4(m, seV3Assign(in.x[i], in.y[i], in.z[i]));
+        out.x[i] = v.x;
+        out.y[i] = v.y;
+        out.z[i] = v.z;
+    }
+}
+
+/* 
+ * seV3NormalizeBatch:
+ * Normalizes count vectors.
+ * 
+ */
+void seV3NormalizeBatch(seVec3s in, seVec3s out, int count)
+{
+    for (int i = 0; i < count; i++) {
+        seVec3 v = seV3Normalize(seV3Assign(in.x[i], in.y[i], in.z[i]));
+        out.x[i] = v.x;
+        out.y[i] = v.y;
+        out.z[i] = v.z;
+    }
+}
+
+/* 
+ * seV3NormalizeIndexed:
+ * Normalizes only the count vectors named by index.
+ * 
+ */
+void seV3NormalizeIndexed(seVec3s in, seVec3s out, const unsigned int *index, int count)
+{
+    for (int n = 0; n < count; n++) {
+        unsigned int i = index[n];
+        seVec3 v = seV3Normalize(seV3Assign(in.x[i], in.y[i], in.z[i]));
+        out.x[i] = v.x;
+        out.y[i] = v.y;
+        out.z[i] = v.z;
+    }
+}
+
+/* 
+ * seFastRsqrt:
+ * Returns an approximation of 1 / sqrt(x) for positive x, from the
+ * bit-level initial guess refined by one Newton step (relative error
+ * below 0.2%), for renormalizing vectors that are already near unit
+ * length.
+ * 
+ */
+seFloat seFastRsqrt(seFloat x)
+{
+    float y = (float)x;
+    unsigned int i;
+
+    memcpy(&i, &y, sizeof(i));
+    i = 0x5f375a86u - (i >> 1);
+    memcpy(&y, &i, sizeof(y));
+    return y * (1.5f - 0.5f * (float)x * y * y);
+}
+
+/* 
+ * seV3NormalizeFastBatch:
+ * Normalizes count vectors with seFastRsqrt. Zero vectors are left as
+ * they are.
+ * 
+ */
+void seV3NormalizeFastBatch(seVec3s in, seVec3s out, int count)
+{
+    for (int i = 0; i < count; i++) {
+        seFloat x = in.x[i], y = in.y[i], z = in.z[i];
+        seFloat len2 = x * x + y * y + z * z;
+        seFloat s = len2 > 0 ? seFastRsqrt(len2) : 1;
+        out.x[i] = x * s;
+        out.y[i] = y * s;
+        out.z[i] = z * s;
+    }
+}
+
+/* 
+ * seM4MultiplyBatch:
+ * Multiplies count pairs of matrices, out[i] = a[i] * b[i].
+ * 
+ */
+void seM4MultiplyBatch(const seMat4 *a, const seMat4 *b, seMat4 *out, int count)
+{
+    for (int i = 0; i < count; i++)
+        out[i] = seM4Multiply(a[i], b[i]);
+}
+
+/* 
+ * seM4MultiplyIndexed:
+ * Multiplies only the count pairs of matrices named by index.
+ * 
+ */
+void seM4MultiplyIndexed(const seMat4 *a, const seMat4 *b, seMat4 *out, const unsigned int *index, int count)
+{
+    for (int n = 0; n < count; n++) {
+        unsigned int i = index[n];
+        out[i] = seM4Multiply(a[i], b[i]);
+    }
+}
+
+/* Batch Partitioning */
+
+#ifndef SE_PAGE_SIZE
+#define SE_PAGE_SIZE 4096
+#endif
+
+/* 
+ * seBatchRange:
+ * Splits count elements of elementSize bytes into parts contiguous
+ * ranges and writes the first element and length of range part to
+ * first and n. Range boundaries fall on SE_PAGE_SIZE boundaries of a
+ * page-aligned stream, so no page (or cache line) is shared between
+ * ranges; trailing ranges may be empty when count is small.
+ * 
+ * For NUMA machines, have each worker initialize its range of every
+ * stream (first touch) and later process the same range, so the pages
+ * it works on were allocated on its own node. Numbering the parts node
+ * by node (part = node * threadsPerNode + thread) keeps each node's
+ * ranges adjacent. Discovering the topology and pinning the workers is
+ * left to the caller's thread pool.
+ * 
+ */
+void seBatchRange(int count, int elementSize, int parts, int part, int *first, int *n)
+{
+    int g = SE_PAGE_SIZE, e = elementSize;
+    int unit, units, begin, end;
+
+    // the smallest element count that spans a whole number of pages
+    while (e) {
+        int t = g % e;
+        g = e;
+        e = t;
+    }
+    unit = SE_PAGE_SIZE / g;
+    units = (count + unit - 1) / unit;
+
+    begin = (int)((long long)units * part / parts) * unit;
+    end = (int)((long long)units * (part + 1) / parts) * unit;
+    begin = begin < count ? begin : count;
+    end = end < count ? end : count;
+
+    *first = begin;
+    *n = end - begin;
+}
+
+/* Autotuning */
+
+/* 
+ * seTuneClass:
+ * Returns the seTuning size class of a batch of count elements: class k
+ * covers counts below 4096 * 4^k, and the last class everything larger.
+ * 
+ */
+int seTuneClass(int count)
+{
+    int k = 0;
+
+    for (long long limit = 4096; k < SE_TUNE_CLASSES - 1 && count >= limit; limit *= 4)
+        k++;
+    return k;
+}
+
+/* 
+ * seTuningDefault:
+ * Fills a profile with untuned defaults: streaming stores once a
+ * transform's input and output exceed SE_LLC_SIZE, and 4096-element
+ * chunks.
+ * 
+ */
+void seTuningDefault(seTuning *t)
+{
+    for (int k = 0; k < SE_TUNE_CLASSES; k++) {
+        double top = 4096.0 * pow(4, k);
+        t->store[k] = top * 6 * sizeof(seFloat) > SE_LLC_SIZE ? SE_STORE_STREAM : SE_STORE_CACHED;
+    }
+    t->chunk = 4096;
+}
+
+/* 
+ * seTuneRun:
+ * Times a transform-then-normalize pipeline over count points, run
+ * chunk points at a time with the given store mode, and returns the
+ * best seconds per point over a few repetitions. This is the workload
+ * seTune measures.
+ * 
+ */
+double seTuneRun(seVec3s in, seVec3s out, int count, int mode, int chunk)
+{
+    seMat4 m = seM4Multiply(seM4Translate(1, 2, 3), seM4RotateAA(seV3Assign(0, 1, 0), 30));
+    double best = HUGE_VAL, total = 0;
+
+    for (int rep = 0; rep < 3 || (rep < 100 && total < 0.02); rep++) {
+        clock_t start = clock();
+        double t;
+
+        for (int i = 0; i < count; i += chunk) {
+            int n = count - i < chunk ? count - i : chunk;
+            seVec3s a, b;
+            a.x = in.x + i;
+            a.y = in.y + i;
+            a.z = in.z + i;
+            b.x = out.x + i;
+            b.y = out.y + i;
+            b.z = out.z + i;
+            seV3TransformM4Stream(m, a, b, n, mode);
+            seV3NormalizeBatch(b, b, n);
+        }
+
+        t = (double)(clock() - start) / CLOCKS_PER_SEC;
+        total += t;
+        best = t < best ? t : best;
+    }
+
+    return best / (count > 0 ? count : 1);
+}
+
+/* 
+ * seTune:
+ * Measures this machine and fills a profile: for every size class that
+ * fits in scratch (floats seFloats), whether cached or streaming stores
+ * are faster for seV3TransformM4Stream, and the chunk size that gives
+ * the fastest pipelined batch work. Classes too large to measure take
+ * the choice of the largest one measured. Takes from a fraction of a
+ * second to a few seconds; run it at install or first run and keep the
+ * result with seTuningSave.
+ * 
+ */
+void seTune(seTuning *t, seFloat *scratch, size_t floats)
+{
+    int capacity = (int)(floats / 6 < 0x7fffffff ? floats / 6 : 0x7fffffff);
+    seVec3s in, out;
+    double best = HUGE_VAL;
+    int measured = -1;
+
+    seTuningDefault(t);
+    in.x = scratch;
+    in.y = in.x + capacity;
+    in.z = in.y + capacity;
+    out.x = in.z + capacity;
+    out.y = out.x + capacity;
+    out.z = out.y + capacity;
+    for (int i = 0; i < 3 * capacity; i++)
+        scratch[i] = 1 + (seFloat)(i % 97) / 97;
+
+    // a representative count from the middle of each class
+    for (int k = 0; k < SE_TUNE_CLASSES; k++) {
+        int count = (int)(2048 * pow(4, k));
+        if (count > capacity)
+            break;
+        // streaming has to win clearly, as it costs whoever reads next
+        t->store[k] = seTuneRun(in, out, count, SE_STORE_STREAM, count) <
+                      0.95 * seTuneRun(in, out, count, SE_STORE_CACHED, count) ? SE_STORE_STREAM : SE_STORE_CACHED;
+        measured = k;
+    }
+    for (int k = measured + 1; measured >= 0 && k < SE_TUNE_CLASSES; k++)
+        t->store[k] = t->store[measured];
+
+    // chunks small enough to stay in cache between the two passes win,
+    // until per-chunk overhead takes over
+    if (capacity >= 1 << 16) {
+        int count = capacity < 1 << 20 ? capacity : 1 << 20;
+        for (int chunk = 256; chunk <= 1 << 16; chunk *= 2) {
+            int k = seTuneClass(count);
+            double s = seTuneRun(in, out, count, t->store[k], chunk);
+            if (s < best * 0.98) {
+                best = s;
+                t->chunk = chunk;
+            }
+        }
+    }
+}
+
+/* 
+ * seTuningActive:
+ * The profile the library tunes itself by, if any: SE_STORE_AUTO
+ * follows its store modes and seCursorNext hands out steps of its chunk
+ * size. Set it once, e.g. after seTuningLoad, before any batch work
+ * that might read it runs.
+ * 
+ */
+const seTuning *seTuningActive = NULL;
+
+/* 
+ * seTuningStoreMode:
+ * Returns the store mode a profile picked for a transform of count
+ * points, for passing to seV3TransformM4Stream. A NULL profile means
+ * seTuningActive, or the SE_LLC_SIZE rule if that is NULL too.
+ * 
+ */
+int seTuningStoreMode(const seTuning *t, int count)
+{
+    if (!t)
+        t = seTuningActive;
+    if (!t)
+        return (double)count * 6 * sizeof(seFloat) > SE_LLC_SIZE ? SE_STORE_STREAM : SE_STORE_CACHED;
+    return t->store[seTuneClass(count)];
+}
+
+/* 
+ * seTuningSave:
+ * Writes a profile to a small text file. Returns nonzero on success.
+ * 
+ */
+int seTuningSave(const seTuning *t, const char *path)
+{
+    FILE *f = fopen(path, "w");
+    int ok;
+
+    if (!f)
+        return 0;
+    fprintf(f, "3Dmath-tuning %d\n", SE_TUNING_VERSION);
+    for (int k = 0; k < SE_TUNE_CLASSES; k++)
+        fprintf(f, "store %d %s\n", k, t->store[k] == SE_STORE_STREAM ? "stream" : "cached");
+    fprintf(f, "chunk %d\n", t->chunk);
+    ok = !ferror(f);
+    return fclose(f) == 0 && ok;
+}
+
+/* 
+ * seTuningLoad:
+ * Reads a profile written by seTuningSave. Entries missing from the
+ * file keep their seTuningDefault values and unknown lines are skipped,
+ * so optional entries can come and go within a format version. Returns
+ * zero, with t left at the defaults, if the file can't be read or was
+ * written for another SE_TUNING_VERSION.
+ * 
+ */
+int seTuningLoad(seTuning *t, const char *path)
+{
+    FILE *f = fopen(path, "r");
+    char line[128], mode[16];
+    int k, n, version;
+
+    seTuningDefault(t);
+    if (!f)
+        return 0;
+    if (!fgets(line, sizeof(line), f) || sscanf(line, "3Dmath-tuning %d", &version) != 1 ||
+        version != SE_TUNING_VERSION) {
+        fclose(f);
+        return 0;
+    }
+
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "store %d %15s", &k, mode) == 2 && k >= 0 && k < SE_TUNE_CLASSES)
+            t->store[k] = strcmp(mode, "stream") == 0 ? SE_STORE_STREAM : SE_STORE_CACHED;
+        else if (sscanf(line, "chunk %d", &n) == 1 && n > 0)
+            t->chunk = n;
+    }
+
+    fclose(f);
+    return 1;
+}
+
+/* Resumable Batches */
+
+#ifndef SE_CURSOR_STEP
+#define SE_CURSOR_STEP 256
+#endif
+
+#ifndef SE_NOW
+#define SE_NOW() ((double)clock() / CLOCKS_PER_SEC)
+#endif
+
+/* 
+ * seCursorInit:
+ * Starts a cursor over a job of count elements, with no budget set.
+ * 
+ */
+void seCursorInit(seCursor *c, int count)
+{
+    c->next = 0;
+    c->count = count;
+    c->budget = 0;
+    c->deadline = 0;
+}
+
+/* 
+ * seCursorBudget:
+ * Sets the budget for the next slice of work: at most elements more
+ * elements and seconds more seconds by SE_NOW(). Either limit is off
+ * when not positive. Call it once per frame before resuming the job.
+ * 
+ * SE_NOW() defaults to clock(), which is process CPU time; programs
+ * running other threads alongside should define it to a wall clock.
+ * 
+ */
+void seCursorBudget(seCursor *c, int elements, double seconds)
+{
+    c->budget = elements > 0 ? elements : 0x7fffffff;
+    c->deadline = seconds > 0 ? SE_NOW() + seconds : HUGE_VAL;
+}
+
+/* 
+ * seCursorNext:
+ * Hands out the next step of a job: writes its first element to first
+ * and returns its length, at most SE_CURSOR_STEP or, when it is set,
+ * the chunk size of seTuningActive. Returns 0 once the job is done or
+ * the slice's budget is spent, so a slice overruns its deadline by at
+ * most one step. Any batch kernel can be made resumable by running it
+ * over the steps this hands out.
+ * 
+ */
+int seCursorNext(seCursor *c, int *first)
+{
+    int n = c->count - c->next;
+    int step = seTuningActive && seTuningActive->chunk > 0 ? seTuningActive->chunk : SE_CURSOR_STEP;
+
+    if (n <= 0 || c->budget <= 0 || SE_NOW() >= c->deadline)
+        return 0;
+
+    n = n < step ? n : step;
+    n = n < c->budget ? n : c->budget;
+    *first = c->next;
+    c->next += n;
+    c->budget -= n;
+    return n;
+}
+
+/* 
+ * seCursorDone:
+ * Returns nonzero once every element of the job has been handed out.
+ * 
+ */
+int seCursorDone(const seCursor *c)
+{
+    return c->next >= c->count;
+}
+
+/* 
+ * seM4OrthonormalizeResume:
+ * Continues seM4OrthonormalizeBatch over the matrices of a cursor's job
+ * until its budget is spent. Returns the number corrected in this call.
+ * 
+ */
+int seM4OrthonormalizeResume(seMat4 *m, seCursor *c, seFloat tolerance, int iterations)
+{
+    int fixed = 0, first, n;
+
+    while ((n = seCursorNext(c, &first)) > 0)
+        fixed += seM4OrthonormalizeBatch(m + first, n, tolerance, iterations);
+    return fixed;
+}
+
+/* 
+ * seQFromM4Resume:
+ * Continues seQFromM4Batch over a cursor's job until its budget is
+ * spent.
+ * 
+ */
+void seQFromM4Resume(const seMat4 *m, seQuats out, seCursor *c)
+{
+    int first, n;
+
+    while ((n = seCursorNext(c, &first)) > 0) {
+        seQuats q = out;
+        q.x += first;
+        q.y += first;
+        q.z += first;
+        q.w += first;
+        seQFromM4Batch(m + first, q, n);
+    }
+}
+
+/* 
+ * seV3TransformM4Resume:
+ * Continues seV3TransformM4Batch over a cursor's job until its budget
+ * is spent, e.g. to reproject a large point cloud across frames. The
+ * store mode is chosen by seTuningStoreMode for the whole job.
+ * 
+ */
+void seV3TransformM4Resume(seMat4 m, seVec3s in, seVec3s out, seCursor *c)
+{
+    int first, n;
+
+    while ((n = seCursorNext(c, &first)) > 0) {
+        seVec3s a, b;
+        a.x = in.x + first;
+        a.y = in.y + first;
+        a.z = in.z + first;
+        b.x = out.x + first;
+        b.y = out.y + first;
+        b.z = out.z + first;
+        seV3TransformM4Stream(m, a, b, n, seTuningStoreMode(NULL, c->count));
+    }
+}
+
+/* Quaternions */
+
+/* 
+ * seQAssign:
+ * Returns a quaternion with component values specified by the
+ * parameters.
+ * 
+ */
+seQuat seQAssign(seFloat x, seFloat y, seFloat z, seFloat w)
+{
+    seQuat out;
+    out.x = x;
+    out.y = y;
+    out.z = z;
+    out.w = w;
+
+    return out;
+}
+
+/* 
+ * seQIdentity:
+ * Returns the identity rotation.
+ * 
+ */
+seQuat seQIdentity()
+{
+    return seQAssign(0, 0, 0, 1);
+}
+
+/* 
+ * seQMultiply:
+ * Returns the product q1q2, the rotation q2 followed by q1.
+ * 
+ */
+seQuat seQMultiply(seQuat q1, seQuat q2)
+{
+    seQuat out;
+    out.x = (q1.w * q2.x) + (q1.x * q2.w) + (q1.y * q2.z) - (q1.z * q2.y);
+    out.y = (q1.w * q2.y) - (q1.x * q2.z) + (q1.y * q2.w) + (q1.z * q2.x);
+    out.z = (q1.w * q2.z) + (q1.x * q2.y) - (q1.y * q2.x) + (q1.z * q2.w);
+    out.w = (q1.w * q2.w) - (q1.x * q2.x) - (q1.y * q2.y) - (q1.z * q2.z);
+
+    return out;
+}
+
+/* 
+ * seQConjugate:
+ * Returns the conjugate of a quaternion, which is its inverse when the
+ * quaternion is of unit length.
+ * 
+ */
+seQuat seQConjugate(seQuat q)
+{
+    return seQAssign(-q.x, -q.y, -q.z, q.w);
+}
+
+/* 
+ * seQNormalize:
+ * Returns a unit-length version of the specified quaternion.
+ * 
+ */
+seQuat seQNormalize(seQuat q)
+{
+    seFloat len = sqrtf(SE_SQUARED(q.x) + SE_SQUARED(q.y) +
+                        SE_SQUARED(q.z) + SE_SQUARED(q.w));
+
+    return seQAssign(q.x / len, q.y / len, q.z / len, q.w / len);
+}
+
+/* 
+ * seQFromAA:
+ * Constructs and returns a rotation quaternion from an axis and an
+ * angle in degrees, matching seM4RotateAA.
+ * 
+ */
+seQuat seQFromAA(seVec3 v, const seFloat t)
+{
+    v = seV3Normalize(v);
+
+    seFloat c = cosf(SE_DEG2RAD(t) * 0.5f);
+    seFloat s = sinf(SE_DEG2RAD(t) * 0.5f);
+
+    return seQAssign(v.x * s, v.y * s, v.z * s, c);
+}
+
+/* 
+ * seQFromTo:
+ * Returns the shortest rotation that turns the direction of one vector
+ * into the direction of another.
+ * 
+ */
+seQuat seQFromTo(seVec3 from, seVec3 to)
+{
+    from = seV3Normalize(from);
+    to = seV3Normalize(to);
+
+    seFloat d = seV3Dot(from, to);
+    if (d < -0.999999f) {
+        // opposite directions: turn half way around any perpendicular
+        seVec3 axis = seV3Cross(seV3Assign(1, 0, 0), from);
+        if (seV3Dot(axis, axis) < 1e-6f)
+            axis = seV3Cross(seV3Assign(0, 1, 0), from);
+        axis = seV3Normalize(axis);
+        return seQAssign(axis.x, axis.y, axis.z, 0);
+    }
+
+    seVec3 c = seV3Cross(from, to);
+    return seQNormalize(seQAssign(c.x, c.y, c.z, 1 + d));
+}
+
+/* 
+ * seQClampAngle:
+ * Returns the specified rotation with its angle limited to at most t
+ * degrees about the same axis.
+ * 
+ */
+seQuat seQClampAngle(seQuat q, const seFloat t)
+{
+    seFloat c = cosf(SE_DEG2RAD(t) * 0.5f);
+    seFloat w = fabsf(q.w);
+    if (w >= c)
+        return q;
+
+    seFloat s = sqrtf(1 - SE_SQUARED(c)) / sqrtf(1 - SE_SQUARED(w));
+    if (q.w < 0)
+        c = -c;
+
+    return seQAssign(q.x * s, q.y * s, q.z * s, c);
+}
+
+/* 
+ * seV3RotateQ:
+ * Returns a 3D vector rotated by a unit quaternion.
+ * 
+ */
+seVec3 seV3RotateQ(seQuat q, seVec3 v)
+{
+    // v + 2w(u x v) + 2u x (u x v), with u the vector part of q
+    seVec3 u = seV3Assign(q.x, q.y, q.z);
+    seVec3 t = seV3Cross(u, v);
+    t.x *= 2;
+    t.y *= 2;
+    t.z *= 2;
+
+    seVec3 out = seV3Cross(u, t);
+    out.x += v.x + q.w * t.x;
+    out.y += v.y + q.w * t.y;
+    out.z += v.z + q.w * t.z;
+
+    return out;
+}
+
+/* 
+ * seQSlerp:
+ * Returns the spherical linear interpolation between two unit
+ * quaternions along the shorter arc, with t ranging from 0 to 1.
+ * 
+ */
+seQuat seQSlerp(seQuat q1, seQuat q2, const seFloat t)
+{
+    seFloat d = q1.x * q2.x + q1.y * q2.y + q1.z * q2.z + q1.w * q2.w;
+    if (d < 0) {
+        d = -d;
+        q2 = seQAssign(-q2.x, -q2.y, -q2.z, -q2.w);
+    }
+
+    // close quaternions fall back to a normalized lerp
+    seFloat a = 1 - t, b = t;
+    if (d < 0.9995f) {
+        seFloat theta = acosf(d);
+        seFloat s = 1 / sinf(theta);
+        a = sinf(a * theta) * s;
+        b = sinf(b * theta) * s;
+    }
+
+    return seQNormalize(seQAssign(a * q1.x + b * q2.x, a * q1.y + b * q2.y,
+                                  a * q1.z + b * q2.z, a * q1.w + b * q2.w));
+}
+
+/* 
+ * seM4FromQ:
+ * Constructs and returns the rotation transformation matrix of a unit
+ * quaternion.
+ * 
+ */
+seMat4 seM4FromQ(seQuat q)
+{
+    seFloat xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+    seFloat xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+    seFloat wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+
+    seMat4 out;
+    out.e[0]  = 1 - 2 * (yy + zz);
+    out.e[1]  = 2 * (xy - wz);
+    out.e[2]  = 2 * (xz + wy);
+    out.e[4]  = 2 * (xy + wz);
+    out.e[5]  = 1 - 2 * (xx + zz);
+    out.e[6]  = 2 * (yz - wx);
+    out.e[8]  = 2 * (xz - wy);
+    out.e[9]  = 2 * (yz + wx);
+    out.e[10] = 1 - 2 * (xx + yy);
+    out.e[3]  = 0;
+    out.e[7]  = 0;
+    out.e[11] = 0;
+    out.e[12] = 0;
+    out.e[13] = 0;
+    out.e[14] = 0;
+    out.e[15] = 1;
+
+    return out;
+}
+
+/* Rotation Conversions */
+
+/* 
+ * seQFromM4:
+ * Returns the unit quaternion of the rotation block of a 4x4 matrix,
+ * which must be orthonormal (see seM4OrthonormalizeBatch).
+ * 
+ */
+seQuat seQFromM4(seMat4 m)
+{
+    const seFloat *e = m.e;
+    seFloat trace = e[0] + e[5] + e[10];
+    seQuat out;
+
+    // pivot on the largest of w, x, y, z to keep the square root stable
+    if (trace > 0) {
+        seFloat s = 0.5f / sqrtf(trace + 1);
+        out = seQAssign((e[9] - e[6]) * s, (e[2] - e[8]) * s, (e[4] - e[1]) * s, 0.25f / s);
+    } else if (e[0] > e[5] && e[0] > e[10]) {
+        seFloat s = 0.5f / sqrtf(1 + e[0] - e[5] - e[10]);
+        out = seQAssign(0.25f / s, (e[1] + e[4]) * s, (e[2] + e[8]) * s, (e[9] - e[6]) * s);
+    } else if (e[5] > e[10]) {
+        seFloat s = 0.5f / sqrtf(1 + e[5] - e[0] - e[10]);
+        out = seQAssign((e[1] + e[4]) * s, 0.25f / s, (e[6] + e[9]) * s, (e[2] - e[8]) * s);
+    } else {
+        seFloat s = 0.5f / sqrtf(1 + e[10] - e[0] - e[5]);
+        out = seQAssign((e[2] + e[8]) * s, (e[6] + e[9]) * s, 0.25f / s, (e[4] - e[1]) * s);
+    }
+
+    return out;
+}
+
+/* 
+ * seQFromEuler:
+ * Constructs and returns a rotation quaternion from Euler angles in
+ * degrees, in any of the SE_EULER orders.
+ * 
+ */
+seQuat seQFromEuler(seVec3 v, int order)
+{
+    seFloat a[3] = { v.x, v.y, v.z };
+    seQuat out = seQIdentity();
+
+    for (int n = 0; n < 3; n++) {
+        seFloat h = SE_DEG2RAD(a[n]) * 0.5f;
+        seFloat e[3] = { 0, 0, 0 };
+        e[(order >> (4 - 2 * n)) & 3] = sinf(h);
+        out = seQMultiply(out, seQAssign(e[0], e[1], e[2], cosf(h)));
+    }
+
+    return out;
+}
+
+/* 
+ * seM4FromEuler:
+ * Constructs and returns a rotation transformation matrix from Euler
+ * angles in degrees, in any of the SE_EULER orders.
+ * 
+ */
+seMat4 seM4FromEuler(seVec3 v, int order)
+{
+    return seM4FromQ(seQFromEuler(v, order));
+}
+
+/* 
+ * seM4ToEuler:
+ * Extracts Euler angles in degrees, in the specified SE_EULER order,
+ * from the rotation block of a 4x4 matrix. The middle angle is kept in
+ * [-90, 90] for Tait-Bryan orders and [0, 180] for proper Euler orders.
+ * The third angle is read from the matrix rotated back by the first
+ * (Day, Converting a Rotation Matrix to Euler Angles), so the angles
+ * rebuild the matrix all the way into gimbal lock, where the split
+ * between the first and third angle is arbitrary.
+ * 
+ */
+seVec3 seM4ToEuler(seMat4 m, int order)
+{
+    const seFloat *e = m.e;
+    int i = (order >> 4) & 3, j = (order >> 2) & 3, k = order & 3;
+    seFloat a, b, c;
+
+    seFloat s = ((j - i + 3) % 3 == 1) ? 1.0f : -1.0f;
+    seFloat sa, ca;
+
+    // row j of rotate(i, -a) * m is ca * m[j] + s * sa * m[k], and it
+    // leaves a rotation about j then one about the last axis
+    if (i == k) {
+        k = 3 - i - j;
+        seFloat sb = sqrtf(SE_SQUARED(e[i * 4 + j]) + SE_SQUARED(e[i * 4 + k]));
+        b = atan2f(sb, e[i * 4 + i]);
+        a = atan2f(e[j * 4 + i], -s * e[k * 4 + i]);
+        sa = sinf(a);
+        ca = cosf(a);
+        c = atan2f(-s * ca * e[j * 4 + k] - sa * e[k * 4 + k],
+                   ca * e[j * 4 + j] + s * sa * e[k * 4 + j]);
+    } else {
+        seFloat cb = sqrtf(SE_SQUARED(e[i * 4 + i]) + SE_SQUARED(e[i * 4 + j]));
+        b = atan2f(s * e[i * 4 + k], cb);
+        a = atan2f(-s * e[j * 4 + k], e[k * 4 + k]);
+        sa = sinf(a);
+        ca = cosf(a);
+        c = atan2f(s * ca * e[j * 4 + i] + sa * e[k * 4 + i],
+                   ca * e[j * 4 + j] + s * sa * e[k * 4 + j]);
+    }
+
+    return seV3Assign(SE_RAD2DEG(a), SE_RAD2DEG(b), SE_RAD2DEG(c));
+}
+
+/* 
+ * seQToEuler:
+ * Extracts Euler angles in degrees from a unit quaternion, with the
+ * same ranges and gimbal handling as seM4ToEuler.
+ * 
+ */
+seVec3 seQToEuler(seQuat q, int order)
+{
+    return seM4ToEuler(seM4FromQ(q), order);
+}
+
+/* 
+ * seQToAA:
+ * Returns the angle in degrees of a unit quaternion's rotation and
+ * writes its axis. The identity rotation reports the x axis.
+ * 
+ */
+seFloat seQToAA(seQuat q, seVec3 *axis)
+{
+    seFloat s = sqrtf(SE_SQUARED(q.x) + SE_SQUARED(q.y) + SE_SQUARED(q.z));
+    if (s < 1e-8f) {
+        *axis = seV3Assign(1, 0, 0);
+        return 0;
+    }
+
+    *axis = seV3Assign(q.x / s, q.y / s, q.z / s);
+    return SE_RAD2DEG(2 * atan2f(s, q.w));
+}
+
+/* 
+ * seQFromEulerBatch:
+ * Converts count sets of Euler angles to quaternions.
+ * 
+ */
+void seQFromEulerBatch(seVec3s v, int order, seQuats out, int count)
+{
+    for (int i = 0; i < count; i++) {
+        seQuat q = seQFromEuler(seV3Assign(v.x[i], v.y[i], v.z[i]), order);
+        out.x[i] = q.x;
+        out.y[i] = q.y;
+        out.z[i] = q.z;
+        out.w[i] = q.w;
+    }
+}
+
+/* 
+ * seQToEulerBatch:
+ * Converts count quaternions to Euler angles.
+ * 
+ */
+void seQToEulerBatch(seQuats q, int order, seVec3s out, int count)
+{
+    for (int i = 0; i < count; i++) {
+        seVec3 v = seQToEuler(seQAssign(q.x[i], q.y[i], q.z[i], q.w[i]), order);
+        out.x[i] = v.x;
+        out.y[i] = v.y;
+        out.z[i] = v.z;
+    }
+}
+
+/* 
+ * seM4FromEulerBatch:
+ * Converts count sets of Euler angles to rotation matrices.
+ * 
+ */
+void seM4FromEulerBatch(seVec3s v, int order, seMat4 *out, int count)
+{
+    for (int i = 0; i < count; i++)
+        out[i] = seM4FromEuler(seV3Assign(v.x[i], v.y[i], v.z[i]), order);
+}
+
+/* 
+ * seM4ToEulerBatch:
+ * Extracts Euler angles from count rotation matrices.
+ * 
+ */
+void seM4ToEulerBatch(const seMat4 *m, int order, seVec3s out, int count)
+{
+    for (int i = 0; i < count; i++) {
+        seVec3 v = seM4ToEuler(m[i], order);
+        out.x[i] = v.x;
+        out.y[i] = v.y;
+        out.z[i] = v.z;
+    }
+}
+
+/* 
+ * seQFromM4Batch:
+ * Converts the rotation blocks of count matrices to quaternions.
+ * 
+ */
+void seQFromM4Batch(const seMat4 *m, seQuats out, int count)
+{
+    for (int i = 0; i < count; i++) {
+        seQuat q = seQFromM4(m[i]);
+        out.x[i] = q.x;
+        out.y[i] = q.y;
+        out.z[i] = q.z;
+        out.w[i] = q.w;
+    }
+}
+
+/* 
+ * seM4FromQBatch:
+ * Converts count quaternions to rotation matrices.
+ * 
+ */
+void seM4FromQBatch(seQuats q, seMat4 *out, int count)
+{
+    for (int i = 0; i < count; i++)
+        out[i] = seM4FromQ(seQAssign(q.x[i], q.y[i], q.z[i], q.w[i]));
+}
+
+/* 
+ * seQFromAABatch:
+ * Converts count axis-angle pairs, angles in degrees, to quaternions.
+ * 
+ */
+void seQFromAABatch(seVec3s axis, const seFloat *angle, seQuats out, int count)
+{
+    for (int i = 0; i < count; i++) {
+        seQuat q = seQFromAA(seV3Assign(axis.x[i], axis.y[i], axis.z[i]), angle[i]);
+        out.x[i] = q.x;
+        out.y[i] = q.y;
+        out.z[i] = q.z;
+        out.w[i] = q.w;
+    }
+}
+
+/* 
+ * seQToAABatch:
+ * Converts count quaternions to axis-angle pairs, angles in degrees.
+ * 
+ */
+void seQToAABatch(seQuats q, seVec3s axis, seFloat *angle, int count)
+{
+    for (int i = 0; i < count; i++) {
+        seVec3 v;
+        angle[i] = seQToAA(seQAssign(q.x[i], q.y[i], q.z[i], q.w[i]), &v);
+        axis.x[i] = v.x;
+        axis.y[i] = v.y;
+        axis.z[i] = v.z;
+    }
+}
+
+/* Rigid Transforms */
+
+/* 
+ * seRAssign:
+ * Returns a rigid transform that rotates by q, then translates by t.
+ * 
+ */
+seRigid seRAssign(seQuat q, seVec3 t)
+{
+    seRigid out;
+    out.q = q;
+    out.t = t;
+
+    return out;
+}
+
+/* 
+ * seRIdentity:
+ * Returns the identity rigid transform.
+ * 
+ */
+seRigid seRIdentity()
+{
+    return seRAssign(seQIdentity(), seV3Assign(0, 0, 0));
+}
+
+/* 
+ * seRMultiply:
+ * Returns the composition r1r2, the transform r2 followed by r1, just
+ * as seM4Multiply would for the equivalent matrices.
+ * 
+ */
+seRigid seRMultiply(seRigid r1, seRigid r2)
+{
+    return seRAssign(seQMultiply(r1.q, r2.q), seV3TransformR(r1, r2.t));
+}
+
+/* 
+ * seRInverse:
+ * Returns the inverse of a rigid transform.
+ * 
+ */
+seRigid seRInverse(seRigid r)
+{
+    seQuat q = seQConjugate(r.q);
+    seVec3 t = seV3RotateQ(q, r.t);
+
+    return seRAssign(q, seV3Assign(-t.x, -t.y, -t.z));
+}
+
+/* 
+ * seRInterpolate:
+ * Returns the interpolation between two rigid transforms, slerping the
+ * rotation and lerping the translation, with t ranging from 0 to 1.
+ * 
+ */
+seRigid seRInterpolate(seRigid r1, seRigid r2, const seFloat t)
+{
+    seVec3 v;
+    v.x = r1.t.x + (r2.t.x - r1.t.x) * t;
+    v.y = r1.t.y + (r2.t.y - r1.t.y) * t;
+    v.z = r1.t.z + (r2.t.z - r1.t.z) * t;
+
+    return seRAssign(seQSlerp(r1.q, r2.q, t), v);
+}
+
+/* 
+ * seV3TransformR:
+ * Returns a point transformed by a rigid transform.
+ * 
+ */
+seVec3 seV3TransformR(seRigid r, seVec3 v)
+{
+    return seV3Add(seV3RotateQ(r.q, v), r.t);
+}
+
+/* 
+ * seM4FromR:
+ * Constructs and returns the transformation matrix of a rigid
+ * transform. Meant for the upload boundary; keep transforms rigid
+ * until then.
+ * 
+ */
+seMat4 seM4FromR(seRigid r)
+{
+    seMat4 out = seM4FromQ(r.q);
+    out.e[3]  = r.t.x;
+    out.e[7]  = r.t.y;
+    out.e[11] = r.t.z;
+
+    return out;
+}
+
+/* 
+ * seRLoad:
+ * Returns element i of a rigid transform stream.
+ * 
+ */
+seRigid seRLoad(seRigids r, int i)
+{
+    return seRAssign(seQAssign(r.qx[i], r.qy[i], r.qz[i], r.qw[i]),
+                     seV3Assign(r.tx[i], r.ty[i], r.tz[i]));
+}
+
+/* 
+ * seRStore:
+ * Writes a rigid transform to element i of a stream.
+ * 
+ */
+void seRStore(seRigids r, int i, seRigid v)
+{
+    r.qx[i] = v.q.x;
+    r.qy[i] = v.q.y;
+    r.qz[i] = v.q.z;
+    r.qw[i] = v.q.w;
+    r.tx[i] = v.t.x;
+    r.ty[i] = v.t.y;
+    r.tz[i] = v.t.z;
+}
+
+/* 
+ * seRMultiplyBatch:
+ * Composes count pairs of rigid transforms, out[i] = a[i]b[i]. The
+ * output may alias either input.
+ * 
+ */
+void seRMultiplyBatch(seRigids a, seRigids b, seRigids out, int count)
+{
+    for (int i = 0; i < count; i++)
+        seRStore(out, i, seRMultiply(seRLoad(a, i), seRLoad(b, i)));
+}
+
+/* 
+ * seRInverseBatch:
+ * Inverts count rigid transforms. The output may alias the input.
+ * 
+ */
+void seRInverseBatch(seRigids r, seRigids out, int count)
+{
+    for (int i = 0; i < count; i++)
+        seRStore(out, i, seRInverse(seRLoad(r, i)));
+}
+
+/* 
+ * seV3TransformRBatch:
+ * Transforms count points, each by the rigid transform at the same
+ * index.
+ * 
+ */
+void seV3TransformRBatch(seRigids r, const seFloat *x, const seFloat *y, const seFloat *z, seFloat *ox, seFloat *oy, seFloat *oz, int count)
+{
+    for (int i = 0; i < count; i++) {
+        seVec3 v = seV3TransformR(seRLoad(r, i), seV3Assign(x[i], y[i], z[i]));
+        ox[i] = v.x;
+        oy[i] = v.y;
+        oz[i] = v.z;
+    }
+}
+
+/* 
+ * seM4FromRBatch:
+ * Expands count rigid transforms into matrices for upload.
+ * 
+ */
+void seM4FromRBatch(seRigids r, int count, seMat4 *out)
+{
+    for (int i = 0; i < count; i++)
+        out[i] = seM4FromR(seRLoad(r, i));
+}
+
+/* 
+ * seRMultiplyIndexed:
+ * Composes only the count pairs of rigid transforms named by index.
+ * 
+ */
+void seRMultiplyIndexed(seRigids a, seRigids b, seRigids out, const unsigned int *index, int count)
+{
+    for (int n = 0; n < count; n++) {
+        unsigned int i = index[n];
+        seRStore(out, i, seRMultiply(seRLoad(a, i), seRLoad(b, i)));
+    }
+}
+
+/* 
+ * seV3TransformRIndexed:
+ * Transforms only the count points named by index, each by the rigid
+ * transform at the same position.
+ * 
+ */
+void seV3TransformRIndexed(seRigids r, seVec3s in, seVec3s out, const unsigned int *index, int count)
+{
+    for (int n = 0; n < count; n++) {
+        unsigned int i = index[n];
+        seVec3 v = seV3TransformR(seRLoad(r, i), seV3Assign(in.x[i], in.y[i], in.z[i]));
+        out.x[i] = v.x;
+        out.y[i] = v.y;
+        out.z[i] = v.z;
+    }
+}
+
+/* Instance Buffers */
+
+/* 
+ * seInstanceStride:
+ * Returns the number of seFloats seInstanceBuild* writes per instance
+ * for the given SE_INSTANCE flags and SE_LAYOUT.
+ * 
+ */
+int seInstanceStride(int flags, int layout)
+{
+    int stride = 0;
+    if (flags & SE_INSTANCE_MODEL)
+        stride += 16;
+    if (flags & SE_INSTANCE_MVP)
+        stride += 16;
+    if (flags & SE_INSTANCE_NORMAL)
+        stride += (layout == SE_LAYOUT_STD140) ? 12 : 9;
+
+    return stride;
+}
+
+/* 
+ * seM4FromTRS:
+ * Returns the matrix that scales by s, rotates by r and then
+ * translates by t.
+ * 
+ */
+seMat4 seM4FromTRS(seVec3 t, seQuat r, seVec3 s)
+{
+    seMat4 m = seM4FromQ(r);
+
+    for (int k = 0; k < 12; k += 4) {
+        m.e[k]     *= s.x;
+        m.e[k + 1] *= s.y;
+        m.e[k + 2] *= s.z;
+    }
+    m.e[3]  = t.x;
+    m.e[7]  = t.y;
+    m.e[11] = t.z;
+
+    return m;
+}
+
+/* 
+ * seInstanceWrite:
+ * Writes the matrices of one instance, given its model matrix and the
+ * scale baked into it, and returns the position just past them. The
+ * normal matrix is the model rotation block divided by the squared
+ * scale, which equals its inverse transpose without inverting anything.
+ * 
+ */
+seFloat *seInstanceWrite(seMat4 model, seVec3 scale, const seMat4 *viewProjection, int flags, int layout, seFloat *out)
+{
+    seMat4 m[2];
+    int n = 0;
+
+    if (flags & SE_INSTANCE_MODEL)
+        m[n++] = model;
+    if (flags & SE_INSTANCE_MVP)
+        m[n++] = seM4Multiply(*viewProjection, model);
+
+    for (int i = 0; i < n; i++) {
+        if (layout == SE_LAYOUT_ROW_MAJOR) {
+            memcpy(out, m[i].e, sizeof(m[i].e));
+        } else {
+            for (int c = 0; c < 4; c++)
+                for (int r = 0; r < 4; r++)
+                    out[c * 4 + r] = m[i].e[r * 4 + c];
+        }
+        out += 16;
+    }
+
+    if (flags & SE_INSTANCE_NORMAL) {
+        seFloat s[3] = { 1 / (scale.x * scale.x), 1 / (scale.y * scale.y), 1 / (scale.z * scale.z) };
+        int pad = (layout == SE_LAYOUT_STD140) ? 4 : 3;
+
+        for (int r = 0; r < 3; r++) {
+            for (int c = 0; c < 3; c++) {
+                seFloat v = model.e[r * 4 + c] * s[c];
+                if (layout == SE_LAYOUT_ROW_MAJOR)
+                    out[r * 3 + c] = v;
+                else
+                    out[c * pad + r] = v;
+            }
+        }
+        if (pad == 4)
+            out[3] = out[7] = out[11] = 0;
+        out += pad * 3;
+    }
+
+    return out;
+}
+
+/* 
+ * seInstanceCopy:
+ * Copies n floats of one instance staged by seInstanceWrite to out and
+ * returns the position just past them. With stream set, SE_SSE
+ * defined, n a multiple of 4 (always so for SE_LAYOUT_STD140) and out
+ * 16-byte aligned, the copy uses non-temporal stores, which suit
+ * write-once output to a mapped upload buffer but evict data that is
+ * read again soon; the caller must _mm_sfence before handing the
+ * buffer over.
+ * 
+ */
+seFloat *seInstanceCopy(const seFloat *stage, int n, int stream, seFloat *out)
+{
+#ifdef SE_SSE
+    if (stream && !(n & 3) && !((size_t)out & 15)) {
+        for (int k = 0; k < n; k += 4)
+            _mm_stream_ps(out + k, _mm_loadu_ps(stage + k));
+        return out + n;
+    }
+#else
+    (void)stream;
+#endif
+    memcpy(out, stage, n * sizeof(seFloat));
+    return out + n;
+}
+
+/* 
+ * seInstanceBuildTRS:
+ * Builds the instance data of count objects from SoA translation,
+ * rotation and scale streams in a single pass: each model matrix is
+ * formed, multiplied by the shared view-projection and written to out
+ * in the requested layout, seInstanceStride floats apart. Each
+ * instance is staged on the stack and copied out with seInstanceCopy;
+ * add SE_INSTANCE_STREAM when out is a mapped upload buffer that the
+ * CPU will not read back.
+ * 
+ */
+void seInstanceBuildTRS(seVec3s t, seQuats r, seVec3s s, seMat4 viewProjection, int flags, int layout, int count, seFloat *out)
+{
+    seFloat stage[44];
+    int n = seInstanceStride(flags, layout);
+
+    int stream = flags & SE_INSTANCE_STREAM;
+
+    for (int i = 0; i < count; i++) {
+        seVec3 scale = seV3Assign(s.x[i], s.y[i], s.z[i]);
+        seMat4 m = seM4FromTRS(seV3Assign(t.x[i], t.y[i], t.z[i]),
+                               seQAssign(r.x[i], r.y[i], r.z[i], r.w[i]), scale);
+
+        seInstanceWrite(m, scale, &viewProjection, flags, layout, stage);
+        out = seInstanceCopy(stage, n, stream, out);
+    }
+
+#ifdef SE_SSE
+    // streamed lines must be visible before the buffer is handed over
+    if (stream)
+        _mm_sfence();
+#endif
+}
+
+/* 
+ * seInstanceBuildR:
+ * Like seInstanceBuildTRS, for rigid transforms.
+ * 
+ */
+void seInstanceBuildR(seRigids r, seMat4 viewProjection, int flags, int layout, int count, seFloat *out)
+{
+    seFloat stage[44];
+    int n = seInstanceStride(flags, layout);
+    int stream = flags & SE_INSTANCE_STREAM;
+
+    for (int i = 0; i < count; i++) {
+        seInstanceWrite(seM4FromR(seRLoad(r, i)), seV3Assign(1, 1, 1),
+                        &viewProjection, flags, layout, stage);
+        out = seInstanceCopy(stage, n, stream, out);
+    }
+
+#ifdef SE_SSE
+    if (stream)
+        _mm_sfence();
+#endif
+}
+
+/* Transform Storage */
+
+/* 
+ * seTransformsBytes:
+ * Returns the bytes of memory seTransformsInit needs for capacity
+ * transforms, including slack for alignment.
+ * 
+ */
+size_t seTransformsBytes(int capacity)
+{
+    size_t n = (size_t)(capacity + SE_TRANSFORM_CHUNK - 1) / SE_TRANSFORM_CHUNK * SE_TRANSFORM_CHUNK;
+    size_t line = (n * sizeof(seFloat) + 63) / 64 * 64;
+    size_t ints = (n * sizeof(unsigned int) + 63) / 64 * 64;
+    size_t handles = (n * sizeof(seHandle) + 63) / 64 * 64;
+
+    return 10 * line + n * sizeof(seMat4) + 2 * handles + ints + 63;
+}
+
+/* 
+ * seTransformsInit:
+ * Lays out an empty store for capacity transforms (at most
+ * 2^SE_HANDLE_INDEX_BITS and INT_MAX) in a
+ * caller-owned block of seTransformsBytes(capacity) bytes. Every stream
+ * starts on a 64-byte boundary and holds a whole number of
+ * SE_TRANSFORM_CHUNK blocks.
+ * 
+ */
+void seTransformsInit(seTransforms *ts, void *memory, int capacity)
+{
+    size_t n = (size_t)(capacity + SE_TRANSFORM_CHUNK - 1) / SE_TRANSFORM_CHUNK * SE_TRANSFORM_CHUNK;
+    size_t line = (n * sizeof(seFloat) + 63) / 64 * 64;
+    size_t handles = (n * sizeof(seHandle) + 63) / 64 * 64;
+    unsigned char *p = (unsigned char *)memory + ((64 - (size_t)memory % 64) % 64);
+    seFloat *f[10];
+
+    for (int i = 0; i < 10; i++, p += line)
+        f[i] = (seFloat *)p;
+    ts->position.x = f[0];
+    ts->position.y = f[1];
+    ts->position.z = f[2];
+    ts->rotation.x = f[3];
+    ts->rotation.y = f[4];
+    ts->rotation.z = f[5];
+    ts->rotation.w = f[6];
+    ts->scale.x = f[7];
+    ts->scale.y = f[8];
+    ts->scale.z = f[9];
+    ts->world = (seMat4 *)p;
+    p += n * sizeof(seMat4);
+    ts->handle = (seHandle *)p;
+    ts->generation = (seHandle *)(p + handles);
+    ts->slot = (unsigned int *)(p + 2 * handles);
+
+    ts->count = 0;
+    ts->capacity = capacity;
+    ts->slots = (int)n;
+    ts->used = 0;
+    ts->free = ts->freeLast = -1;
+}
+
+/* 
+ * seTransformsAdd:
+ * Appends a transform to the dense streams and returns its handle, or
+ * SE_HANDLE_NONE if the store is full. Handle indices of removed
+ * transforms are reused oldest first, each time with a new generation,
+ * so a stale handle could only match again after 2^32 reuses of its
+ * index (with the default split); an index whose generation runs out is
+ * retired instead of wrapping.
+ * 
+ */
+seHandle seTransformsAdd(seTransforms *ts, seVec3 position, seQuat rotation, seVec3 scale)
+{
+    int i = ts->count;
+    unsigned int index;
+
+    if (i >= ts->capacity)
+        return SE_HANDLE_NONE;
+
+    if (ts->free >= 0) {
+        // a free index's slot entry links to the next one in the queue
+        index = ts->free;
+        ts->free = (int)ts->slot[index];
+        if (ts->free < 0)
+            ts->freeLast = -1;
+    } else if (ts->used < ts->slots) {
+        index = ts->used++;
+        ts->generation[index] = 1;
+    } else {
+        // only possible once indices have been retired
+        return SE_HANDLE_NONE;
+    }
+
+    ts->slot[index] = i;
+    ts->handle[i] = (ts->generation[index] << SE_HANDLE_INDEX_BITS) | index;
+    ts->position.x[i] = position.x;
+    ts->position.y[i] = position.y;
+    ts->position.z[i] = position.z;
+    ts->rotation.x[i] = rotation.x;
+    ts->rotation.y[i] = rotation.y;
+    ts->rotation.z[i] = rotation.z;
+    ts->rotation.w[i] = rotation.w;
+    ts->scale.x[i] = scale.x;
+    ts->scale.y[i] = scale.y;
+    ts->scale.z[i] = scale.z;
+    ts->world[i] = seM4Identity();
+    ts->count++;
+
+    return ts->handle[i];
+}
+
+/* 
+ * seTransformsIndex:
+ * Returns the current position of a handle's transform in the dense
+ * streams, or -1 if the handle is stale or invalid. Positions change
+ * when other transforms are removed; handles don't.
+ * 
+ */
+int seTransformsIndex(const seTransforms *ts, seHandle h)
+{
+    seHandle index = h & SE_HANDLE_INDEX_MASK;
+
+    if (h == SE_HANDLE_NONE || index >= (seHandle)ts->used ||
+        ts->generation[index] != h >> SE_HANDLE_INDEX_BITS)
+        return -1;
+    return ts->slot[index];
+}
+
+/* 
+ * seTransformsRemove:
+ * Removes a handle's transform by moving the last transform into its
+ * place, so the streams stay dense. Returns zero if the handle was
+ * already stale.
+ * 
+ */
+int seTransformsRemove(seTransforms *ts, seHandle h)
+{
+    int i = seTransformsIndex(ts, h);
+    int last = ts->count - 1;
+    unsigned int index = (unsigned int)(h & SE_HANDLE_INDEX_MASK);
+
+    if (i < 0)
+        return 0;
+
+    if (i != last) {
+        seHandle moved = ts->handle[last];
+        ts->position.x[i] = ts->position.x[last];
+        ts->position.y[i] = ts->position.y[last];
+        ts->position.z[i] = ts->position.z[last];
+        ts->rotation.x[i] = ts->rotation.x[last];
+        ts->rotation.y[i] = ts->rotation.y[last];
+        ts->rotation.z[i] = ts->rotation.z[last];
+        ts->rotation.w[i] = ts->rotation.w[last];
+        ts->scale.x[i] = ts->scale.x[last];
+        ts->scale.y[i] = ts->scale.y[last];
+        ts->scale.z[i] = ts->scale.z[last];
+        ts->world[i] = ts->world[last];
+        ts->handle[i] = moved;
+        ts->slot[moved & SE_HANDLE_INDEX_MASK] = i;
+    }
+    ts->count--;
+
+    // an index whose generation is used up is never handed out again
+    if (ts->generation[index] == SE_HANDLE_GENERATION_MAX)
+        return 1;
+    ts->generation[index]++;
+
+    // queue the index behind the other free ones, so it is reused last
+    ts->slot[index] = (unsigned int)-1;
+    if (ts->freeLast >= 0)
+        ts->slot[ts->freeLast] = index;
+    else
+        ts->free = index;
+    ts->freeLast = index;
+
+    return 1;
+}
+
+/* 
+ * seTransformsChunk:
+ * Writes the first dense position of chunk k to first and returns its
+ * length: SE_TRANSFORM_CHUNK transforms, fewer for the last chunk, 0
+ * past the end. Chunks start on 64-byte boundaries of every stream and
+ * are independent, so they can be handed to threads and fed straight
+ * to the batch kernels by offsetting the streams by first.
+ * 
+ */
+int seTransformsChunk(const seTransforms *ts, int k, int *first)
+{
+    int n = ts->count - k * SE_TRANSFORM_CHUNK;
+
+    *first = k * SE_TRANSFORM_CHUNK;
+    return n <= 0 ? 0 : n < SE_TRANSFORM_CHUNK ? n : SE_TRANSFORM_CHUNK;
+}
+
+/* 
+ * seTransformsUpdate:
+ * Rebuilds the world matrices of count transforms from position first
+ * on from their translation, rotation and scale, each premultiplied by
+ * parent (the identity for root transforms). The matrices are written
+ * with ordinary stores, since the multiply and cull passes read them
+ * next.
+ * 
+ */
+void seTransformsUpdate(seTransforms *ts, seMat4 parent, int first, int count)
+{
+    for (int i = first; i < first + count; i++) {
+        seMat4 m = seM4FromTRS(seV3Assign(ts->position.x[i], ts->position.y[i], ts->position.z[i]),
+                               seQAssign(ts->rotation.x[i], ts->rotation.y[i], ts->rotation.z[i], ts->rotation.w[i]),
+                               seV3Assign(ts->scale.x[i], ts->scale.y[i], ts->scale.z[i]));
+        ts->world[i] = seM4Multiply(parent, m);
+    }
+}
+
+/* Hashing and Deduplication */
+
+/* 
+ * seHashWords:
+ * Hashes count 32-bit words (count a multiple of 4) in four independent
+ * lanes, so compilers can keep the lanes in one SIMD register, then
+ * folds the lanes and applies the murmur3 finalizer.
+ * 
+ */
+unsigned int seHashWords(const unsigned int *w, int count, unsigned int seed)
+{
+    unsigned int h[4] = { seed, seed ^ 0x85ebca6bu, seed ^ 0xc2b2ae35u, seed ^ 0x27d4eb2fu };
+    unsigned int out;
+
+    for (int i = 0; i < count; i += 4) {
+        for (int l = 0; l < 4; l++) {
+            unsigned int k = w[i + l] * 0xcc9e2d51u;
+            k = (k << 15) | (k >> 17);
+            h[l] = (h[l] ^ (k * 0x1b873593u)) * 0x9e3779b1u;
+        }
+    }
+
+    out = h[0] ^ ((h[1] << 7) | (h[1] >> 25)) ^ ((h[2] << 13) | (h[2] >> 19)) ^ ((h[3] << 21) | (h[3] >> 11));
+    out ^= (unsigned int)count;
+    out ^= out >> 16;
+    out *= 0x85ebca6bu;
+    out ^= out >> 13;
+    out *= 0xc2b2ae35u;
+    out ^= out >> 16;
+    return out;
+}
+
+/* 
+ * seM4Hash:
+ * Returns a 32-bit hash of the bits of a matrix, consistent with
+ * bitwise equality (so 0.0 and -0.0 hash differently).
+ * 
+ */
+unsigned int seM4Hash(const seMat4 *m)
+{
+    unsigned int w[16];
+
+    memcpy(w, m->e, sizeof(w));
+    return seHashWords(w, 16, 0);
+}
+
+/* 
+ * seV3Hash:
+ * Returns a 32-bit hash of the bits of a vector.
+ * 
+ */
+unsigned int seV3Hash(seVec3 v)
+{
+    unsigned int w[4] = { 0, 0, 0, 0 };
+
+    memcpy(&w[0], &v.x, sizeof(w[0]));
+    memcpy(&w[1], &v.y, sizeof(w[1]));
+    memcpy(&w[2], &v.z, sizeof(w[2]));
+    return seHashWords(w, 4, 0);
+}
+
+/* 
+ * seM4HashBatch:
+ * Hashes count matrices. Matrices are independent, so large arrays can
+ * be hashed in slices on several threads before a serial
+ * seM4SetInsertBatch.
+ * 
+ */
+void seM4HashBatch(const seMat4 *m, unsigned int *hash, int count)
+{
+    for (int i = 0; i < count; i++)
+        hash[i] = seM4Hash(&m[i]);
+}
+
+/* 
+ * seM4SetInit:
+ * Sets up an empty matrix set over caller-owned storage: table holds
+ * 2 * size unsigned ints, size a power of two comfortably larger than
+ * the number of distinct matrices expected (twice is plenty), and
+ * unique has room for capacity matrices.
+ * 
+ */
+void seM4SetInit(seM4Set *set, unsigned int *table, int size, seMat4 *unique, int capacity)
+{
+    set->table = table;
+    set->size = size;
+    set->unique = unique;
+    set->capacity = capacity;
+    seM4SetClear(set);
+}
+
+/* 
+ * seM4SetClear:
+ * Empties a set and its statistics, e.g. at the start of a frame when
+ * matrices are only deduplicated within the frame. Keep inserting
+ * without clearing to deduplicate across frames.
+ * 
+ */
+void seM4SetClear(seM4Set *set)
+{
+    memset(set->table, 0, 2 * (size_t)set->size * sizeof(*set->table));
+    set->count = 0;
+    set->inserted = 0;
+    set->saved = 0;
+}
+
+/* 
+ * seM4SetInsert:
+ * Adds a matrix with the given hash (from seM4Hash) to a set unless a
+ * bitwise-identical one is already there, and returns its index in
+ * set->unique. Returns -1 if the set is full.
+ * 
+ */
+int seM4SetInsert(seM4Set *set, const seMat4 *m, unsigned int hash)
+{
+    unsigned int mask = set->size - 1;
+
+    // linear probing over (hash, index + 1) pairs; 0 marks an empty slot
+    for (unsigned int s = hash & mask, n = 0; n < (unsigned int)set->size; s = (s + 1) & mask, n++) {
+        unsigned int *slot = set->table + 2 * s;
+
+        if (slot[1] == 0) {
+            // keep a slot free so probes for new matrices terminate
+            if (set->count >= set->capacity || set->count + 1 >= set->size)
+                return -1;
+            set->unique[set->count] = *m;
+            slot[0] = hash;
+            slot[1] = ++set->count;
+            set->inserted++;
+            return set->count - 1;
+        }
+        if (slot[0] == hash && memcmp(&set->unique[slot[1] - 1], m, sizeof(*m)) == 0) {
+            set->inserted++;
+            set->saved += sizeof(*m);
+            return slot[1] - 1;
+        }
+    }
+
+    return -1;
+}
+
+/* 
+ * seM4SetInsertBatch:
+ * Inserts count matrices and writes each one's index in set->unique to
+ * remap, so per-instance data can refer to the shared copy and only
+ * set->unique needs transforming and uploading. Hashes from
+ * seM4HashBatch may be passed in, or NULL to compute them here. Returns
+ * the number inserted, which is less than count only if the set filled.
+ * 
+ */
+int seM4SetInsertBatch(seM4Set *set, const seMat4 *m, const unsigned int *hash, unsigned int *remap, int count)
+{
+    for (int i = 0; i < count; i++) {
+        int k = seM4SetInsert(set, &m[i], hash ? hash[i] : seM4Hash(&m[i]));
+        if (k < 0)
+            return i;
+        remap[i] = k;
+    }
+    return count;
+}
+
+/* Morph Targets */
+
+/* 
+ * seMorphAdd:
+ * Adds w times count deltas to out at the listed vertices. Indices are
+ * taken in runs of consecutive vertices, each added as one contiguous
+ * multiply-add that compilers vectorize; an index with no neighbour in
+ * the list costs a scalar update. Exporters that list a target's
+ * vertices in order get long runs wherever the moved region was
+ * numbered together.
+ * 
+ */
+void seMorphAdd(seVec3s out, const unsigned int *index, const seFloat *dx, const seFloat *dy, const seFloat *dz, seFloat w, int count)
+{
+    int k = 0;
+
+    while (k < count) {
+        unsigned int first = index[k];
+        int n = 1;
+
+        while (k + n < count && index[k + n] == first + (unsigned int)n)
+            n++;
+
+        seFloat *x = out.x + first, *y = out.y + first, *z = out.z + first;
+        const seFloat *ex = dx + k, *ey = dy + k, *ez = dz + k;
+        for (int j = 0; j < n; j++)
+            x[j] += w * ex[j];
+        for (int j = 0; j < n; j++)
+            y[j] += w * ey[j];
+        for (int j = 0; j < n; j++)
+            z[j] += w * ez[j];
+        k += n;
+    }
+}
+
+/* 
+ * seMorphBlend:
+ * Blends targetCount sparse morph targets into one mesh of vertices
+ * vertices: pos and nrm start as copies of base and baseNrm, and every
+ * target whose weight is larger in magnitude than threshold adds its
+ * weighted deltas at the vertices it lists. Normals are renormalized
+ * with seFastRsqrt afterwards if any target moved them. Pass streams
+ * with NULL x for baseNrm and nrm to blend positions only.
+ * 
+ * Deltas are added with seMorphAdd, which vectorizes over runs of
+ * consecutive vertex indices and is scalar elsewhere. Characters are
+ * independent; blend them on as many threads as there are to spare.
+ * 
+ */
+void seMorphBlend(seVec3s base, seVec3s baseNrm, const seMorphTarget *targets, const seFloat *weights, int targetCount, seFloat threshold, seVec3s pos, seVec3s nrm, int vertices)
+{
+    int normals = nrm.x != NULL && baseNrm.x != NULL, moved = 0;
+
+    memcpy(pos.x, base.x, vertices * sizeof(seFloat));
+    memcpy(pos.y, base.y, vertices * sizeof(seFloat));
+    memcpy(pos.z, base.z, vertices * sizeof(seFloat));
+    if (normals) {
+        memcpy(nrm.x, baseNrm.x, vertices * sizeof(seFloat));
+        memcpy(nrm.y, baseNrm.y, vertices * sizeof(seFloat));
+        memcpy(nrm.z, baseNrm.z, vertices * sizeof(seFloat));
+    }
+
+    for (int t = 0; t < targetCount; t++) {
+        const seMorphTarget *m = &targets[t];
+        seFloat w = weights[t];
+
+        if (fabsf(w) <= threshold)
+            continue;
+
+        seMorphAdd(pos, m->index, m->dx, m->dy, m->dz, w, m->count);
+        if (normals && m->nx) {
+            seMorphAdd(nrm, m->index, m->nx, m->ny, m->nz, w, m->count);
+            moved = 1;
+        }
+    }
+
+    if (moved)
+        seV3NormalizeFastBatch(nrm, nrm, vertices);
+}
+
+/* Noise */
+
+// bring simplex noise to roughly [-1, 1]
+#define SE_SIMPLEX3_SCALE 72.0f
+#define SE_SIMPLEX4_SCALE 62.0f
+
+/* 
+ * seNoiseHash:
+ * Mixes one integer lattice coordinate into a running hash. Lattice
+ * hashing is arithmetic rather than a permutation table, so there are
+ * no gathers in the way of vectorizing, and the seed gives independent
+ * noise fields.
+ * 
+ */
+unsigned int seNoiseHash(unsigned int h, int i)
+{
+    h = (h ^ (unsigned int)i) * 0x27d4eb2du;
+    return h ^ (h >> 15);
+}
+
+/* 
+ * seNoiseGradient:
+ * Writes the lattice gradient for a hash: one axis zeroed and the rest
+ * +-1, which gives Perlin's 12 edge gradients in 3D and 32 in 4D.
+ * 
+ */
+void seNoiseGradient(unsigned int h, int dims, seFloat *g)
+{
+    int zero;
+
+    h *= 0x2c1b3c6du;
+    h ^= h >> 12;
+    zero = (int)((h >> 8) % (unsigned int)dims);
+    for (int d = 0; d < dims; d++)
+        g[d] = d == zero ? 0 : ((h >> d) & 1) ? -1.0f : 1.0f;
+}
+
+/* 
+ * sePerlin:
+ * Improved Perlin gradient noise in dims (3 or 4) dimensions at p, with
+ * the quintic fade. Writes the analytic gradient to gradient (dims
+ * entries) if not NULL. Values lie roughly in [-1, 1] and are 0 at
+ * lattice points.
+ * 
+ */
+seFloat sePerlin(const seFloat *p, int dims, unsigned int seed, seFloat *gradient)
+{
+    int cell[4];
+    seFloat f[4], s[4], ds[4], grad[4];
+    seFloat value = 0;
+
+    for (int d = 0; d < dims; d++) {
+        seFloat x = floorf(p[d]);
+        cell[d] = (int)x;
+        f[d] = p[d] - x;
+        s[d] = f[d] * f[d] * f[d] * (f[d] * (f[d] * 6 - 15) + 10);
+        ds[d] = 30 * f[d] * f[d] * (f[d] - 1) * (f[d] - 1);
+        if (gradient)
+            gradient[d] = 0;
+    }
+
+    for (int c = 0; c < 1 << dims; c++) {
+        unsigned int h = seed;
+        seFloat w = 1, dot = 0;
+
+        for (int d = 0; d < dims; d++)
+            h = seNoiseHash(h, cell[d] + ((c >> d) & 1));
+        seNoiseGradient(h, dims, grad);
+
+        for (int d = 0; d < dims; d++) {
+            int bit = (c >> d) & 1;
+            dot += grad[d] * (f[d] - bit);
+            w *= bit ? s[d] : 1 - s[d];
+        }
+        value += w * dot;
+
+        if (gradient) {
+            for (int d = 0; d < dims; d++) {
+                // derivative of the corner weight along d
+                seFloat wd = ((c >> d) & 1) ? ds[d] : -ds[d];
+                for (int e = 0; e < dims; e++)
+                    if (e != d)
+                        wd *= ((c >> e) & 1) ? s[e] : 1 - s[e];
+                gradient[d] += wd * dot + w * grad[d];
+            }
+        }
+    }
+
+    return value;
+}
+
+/* 
+ * seSimplex:
+ * Simplex noise in dims (3 or 4) dimensions at p: n + 1 corner
+ * contributions instead of Perlin's 2^n, and no axis-aligned artifacts.
+ * Writes the analytic gradient to gradient (dims entries) if not NULL.
+ * Values lie roughly in [-1, 1].
+ * 
+ */
+seFloat seSimplex(const seFloat *p, int dims, unsigned int seed, seFloat *gradient)
+{
+    seFloat F = (sqrtf(dims + 1.0f) - 1) / dims;
+    seFloat G = (1 - 1 / sqrtf(dims + 1.0f)) / dims;
+    seFloat scale = dims == 3 ? SE_SIMPLEX3_SCALE : SE_SIMPLEX4_SCALE;
+    int cell[4], rank[4];
+    seFloat x0[4], x[4], grad[4];
+    seFloat skew = 0, unskew = 0, value = 0;
+
+    // find the simplex containing p and p's offset from its first corner
+    for (int d = 0; d < dims; d++)
+        skew += p[d];
+    skew *= F;
+    for (int d = 0; d < dims; d++) {
+        cell[d] = (int)floorf(p[d] + skew);
+        unskew += cell[d];
+        rank[d] = 0;
+        if (gradient)
+            gradient[d] = 0;
+    }
+    unskew *= G;
+    for (int d = 0; d < dims; d++)
+        x0[d] = p[d] - (cell[d] - unskew);
+
+    // the corners step along the axes from the largest offset down
+    for (int i = 0; i < dims; i++)
+        for (int j = i + 1; j < dims; j++)
+            rank[x0[i] > x0[j] ? i : j]++;
+
+    for (int k = 0; k <= dims; k++) {
+        unsigned int h = seed;
+        seFloat t = 0.5f, dot = 0;
+
+        for (int d = 0; d < dims; d++) {
+            int o = rank[d] >= dims - k;
+            x[d] = x0[d] - o + k * G;
+            t -= x[d] * x[d];
+            h = seNoiseHash(h, cell[d] + o);
+        }
+        if (t <= 0)
+            continue;
+
+        seNoiseGradient(h, dims, grad);
+        for (int d = 0; d < dims; d++)
+            dot += grad[d] * x[d];
+        value += t * t * t * t * dot;
+
+        if (gradient)
+            for (int d = 0; d < dims; d++)
+                gradient[d] += scale * (t * t * t * (t * grad[d] - 8 * x[d] * dot));
+    }
+
+    return scale * value;
+}
+
+/* 
+ * sePerlin3:
+ * 3D Perlin noise at p; see sePerlin.
+ * 
+ */
+seFloat sePerlin3(seVec3 p, unsigned int seed, seVec3 *gradient)
+{
+    seFloat v[3] = { p.x, p.y, p.z }, g[3];
+    seFloat n = sePerlin(v, 3, seed, gradient ? g : NULL);
+
+    if (gradient)
+        *gradient = seV3Assign(g[0], g[1], g[2]);
+    return n;
+}
+
+/* 
+ * seSimplex3:
+ * 3D simplex noise at p; see seSimplex.
+ * 
+ */
+seFloat seSimplex3(seVec3 p, unsigned int seed, seVec3 *gradient)
+{
+    seFloat v[3] = { p.x, p.y, p.z }, g[3];
+    seFloat n = seSimplex(v, 3, seed, gradient ? g : NULL);
+
+    if (gradient)
+        *gradient = seV3Assign(g[0], g[1], g[2]);
+    return n;
+}
+
+/* 
+ * seNoiseDot3:
+ * Returns the dot product of the seNoiseGradient of a hash in 3D with
+ * (x, y, z). The gradient components are formed arithmetically, without
+ * loops or selects, so callers stay vectorizable.
+ * 
+ */
+seFloat seNoiseDot3(unsigned int h, seFloat x, seFloat y, seFloat z)
+{
+    int zero;
+
+    h *= 0x2c1b3c6du;
+    h ^= h >> 12;
+    zero = (int)((h >> 8) % 3);
+    x *= (seFloat)((zero != 0) * (1 - 2 * (int)(h & 1)));
+    y *= (seFloat)((zero != 1) * (1 - 2 * (int)((h >> 1) & 1)));
+    z *= (seFloat)((zero != 2) * (1 - 2 * (int)((h >> 2) & 1)));
+    return x + y + z;
+}
+
+/* 
+ * sePerlin3Batch:
+ * Evaluates sePerlin3 (without gradients) at count points given as SoA
+ * streams. The body has no loops or branches per point, so compilers
+ * vectorize it across points; results match sePerlin3 to rounding.
+ * 
+ */
+void sePerlin3Batch(seVec3s p, unsigned int seed, seFloat *out, int count)
+{
+    for (int i = 0; i < count; i++) {
+        // floor by truncation, as floorf only vectorizes without
+        // -ftrapping-math; fine for |p| < 2^31
+        int cx = (int)p.x[i], cy = (int)p.y[i], cz = (int)p.z[i];
+        cx -= p.x[i] < cx;
+        cy -= p.y[i] < cy;
+        cz -= p.z[i] < cz;
+        seFloat x = p.x[i] - cx, y = p.y[i] - cy, z = p.z[i] - cz;
+        seFloat sx = x * x * x * (x * (x * 6 - 15) + 10);
+        seFloat sy = y * y * y * (y * (y * 6 - 15) + 10);
+        seFloat sz = z * z * z * (z * (z * 6 - 15) + 10);
+        unsigned int h0 = seNoiseHash(seed, cx), h1 = seNoiseHash(seed, cx + 1);
+        unsigned int h00 = seNoiseHash(h0, cy), h01 = seNoiseHash(h0, cy + 1);
+        unsigned int h10 = seNoiseHash(h1, cy), h11 = seNoiseHash(h1, cy + 1);
+
+        // corners named by their x, y, z offsets
+        seFloat n000 = seNoiseDot3(seNoiseHash(h00, cz), x, y, z);
+        seFloat n001 = seNoiseDot3(seNoiseHash(h00, cz + 1), x, y, z - 1);
+        seFloat n010 = seNoiseDot3(seNoiseHash(h01, cz), x, y - 1, z);
+        seFloat n011 = seNoiseDot3(seNoiseHash(h01, cz + 1), x, y - 1, z - 1);
+        seFloat n100 = seNoiseDot3(seNoiseHash(h10, cz), x - 1, y, z);
+        seFloat n101 = seNoiseDot3(seNoiseHash(h10, cz + 1), x - 1, y, z - 1);
+        seFloat n110 = seNoiseDot3(seNoiseHash(h11, cz), x - 1, y - 1, z);
+        seFloat n111 = seNoiseDot3(seNoiseHash(h11, cz + 1), x - 1, y - 1, z - 1);
+
+        seFloat n00 = n000 + sz * (n001 - n000), n01 = n010 + sz * (n011 - n010);
+        seFloat n10 = n100 + sz * (n101 - n100), n11 = n110 + sz * (n111 - n110);
+        seFloat n0 = n00 + sy * (n01 - n00), n1 = n10 + sy * (n11 - n10);
+        out[i] = n0 + sx * (n1 - n0);
+    }
+}
+
+/* 
+ * seSimplex3Corner:
+ * Returns the unscaled contribution of lattice corner (cx, cy, cz) to
+ * 3D simplex noise at offset (x, y, z) from it, zero once out of range.
+ * 
+ */
+seFloat seSimplex3Corner(unsigned int seed, int cx, int cy, int cz, seFloat x, seFloat y, seFloat z)
+{
+    seFloat t = 0.5f - x * x - y * y - z * z;
+    unsigned int h = seNoiseHash(seNoiseHash(seNoiseHash(seed, cx), cy), cz);
+
+    // max(t, 0) without a compare the vectorizer would turn into a branch
+    t = (t + fabsf(t)) * 0.5f;
+    return t * t * t * t * seNoiseDot3(h, x, y, z);
+}
+
+/* 
+ * seSimplex3Batch:
+ * Evaluates seSimplex3 (without gradients) at count points given as
+ * SoA streams, branch-free like sePerlin3Batch.
+ * 
+ */
+void seSimplex3Batch(seVec3s p, unsigned int seed, seFloat *out, int count)
+{
+    const seFloat F = 1.0f / 3, G = 1.0f / 6;
+
+    for (int i = 0; i < count; i++) {
+        seFloat skew = (p.x[i] + p.y[i] + p.z[i]) * F;
+        seFloat sx = p.x[i] + skew, sy = p.y[i] + skew, sz = p.z[i] + skew;
+        int cx = (int)sx, cy = (int)sy, cz = (int)sz;
+        cx -= sx < cx;
+        cy -= sy < cy;
+        cz -= sz < cz;
+        seFloat unskew = (seFloat)(cx + cy + cz) * G;
+        seFloat x0 = p.x[i] - (cx - unskew);
+        seFloat y0 = p.y[i] - (cy - unskew);
+        seFloat z0 = p.z[i] - (cz - unskew);
+        int rx = (x0 > y0) + (x0 > z0);
+        int ry = !(x0 > y0) + (y0 > z0);
+        int rz = !(x0 > z0) + !(y0 > z0);
+
+        // the middle corners step along the largest, then the two
+        // largest offsets
+        int ax = rx >= 2, ay = ry >= 2, az = rz >= 2;
+        int bx = rx >= 1, by = ry >= 1, bz = rz >= 1;
+        seFloat value = seSimplex3Corner(seed, cx, cy, cz, x0, y0, z0);
+        value += seSimplex3Corner(seed, cx + ax, cy + ay, cz + az,
+                                  x0 - ax + G, y0 - ay + G, z0 - az + G);
+        value += seSimplex3Corner(seed, cx + bx, cy + by, cz + bz,
+                                  x0 - bx + 2 * G, y0 - by + 2 * G, z0 - bz + 2 * G);
+        value += seSimplex3Corner(seed, cx + 1, cy + 1, cz + 1,
+                                  x0 - 1 + 3 * G, y0 - 1 + 3 * G, z0 - 1 + 3 * G);
+        out[i] = SE_SIMPLEX3_SCALE * value;
+    }
+}
+
+/* 
+ * seFractal:
+ * Sums octaves of noise as described by a seNoiseParams at p (dims 3 or
+ * 4), each at lacunarity times the previous frequency and gain times
+ * the previous amplitude, and with its own seed. Plain fBm sums the
+ * noise itself; ridged sums (1 - |noise|)^2, which turns zero crossings
+ * into sharp crests. Writes the analytic gradient if not NULL.
+ * 
+ */
+seFloat seFractal(const seNoiseParams *np, const seFloat *p, int dims, seFloat *gradient)
+{
+    seFloat freq = np->frequency, amp = 1, sum = 0;
+    seFloat q[4], g[4];
+
+    if (gradient)
+        for (int d = 0; d < dims; d++)
+            gradient[d] = 0;
+
+    for (int o = 0; o < np->octaves; o++) {
+        seFloat n, k = amp * freq;
+
+        for (int d = 0; d < dims; d++)
+            q[d] = p[d] * freq;
+        if (np->kind == SE_NOISE_SIMPLEX)
+            n = seSimplex(q, dims, np->seed + o, gradient ? g : NULL);
+        else
+            n = sePerlin(q, dims, np->seed + o, gradient ? g : NULL);
+
+        if (np->ridged) {
+            seFloat r = 1 - fabsf(n);
+            sum += amp * r * r;
+            k *= n < 0 ? 2 * r : -2 * r;
+        } else {
+            sum += amp * n;
+        }
+        if (gradient)
+            for (int d = 0; d < dims; d++)
+                gradient[d] += k * g[d];
+
+        freq *= np->lacunarity;
+        amp *= np->gain;
+    }
+
+    return sum;
+}
+
+#ifndef SE_NOISE_CHUNK
+#define SE_NOISE_CHUNK 64
+#endif
+
+/* 
+ * seFractal3Batch:
+ * Evaluates seFractal at count points given as SoA streams, writing the
+ * values to out and, if gradient.x is not NULL, the gradients to
+ * gradient. Points are independent, so large batches can be split
+ * across threads.
+ * 
+ * Values alone run octave by octave over SE_NOISE_CHUNK points at a
+ * time through sePerlin3Batch or seSimplex3Batch, which vectorize.
+ * With gradients each point goes through the scalar seFractal.
+ * 
+ */
+void seFractal3Batch(const seNoiseParams *np, seVec3s p, seFloat *out, seVec3s gradient, int count)
+{
+    if (!gradient.x) {
+        seFloat qx[SE_NOISE_CHUNK], qy[SE_NOISE_CHUNK], qz[SE_NOISE_CHUNK], n[SE_NOISE_CHUNK];
+        seVec3s q;
+        q.x = qx;
+        q.y = qy;
+        q.z = qz;
+
+        for (int first = 0; first < count; first += SE_NOISE_CHUNK) {
+            int m = count - first < SE_NOISE_CHUNK ? count - first : SE_NOISE_CHUNK;
+            seFloat freq = np->frequency, amp = 1;
+            seFloat *sum = out + first;
+
+            for (int i = 0; i < m; i++)
+                sum[i] = 0;
+            for (int o = 0; o < np->octaves; o++) {
+                for (int i = 0; i < m; i++) {
+                    qx[i] = p.x[first + i] * freq;
+                    qy[i] = p.y[first + i] * freq;
+                    qz[i] = p.z[first + i] * freq;
+                }
+                if (np->kind == SE_NOISE_SIMPLEX)
+                    seSimplex3Batch(q, np->seed + o, n, m);
+                else
+                    sePerlin3Batch(q, np->seed + o, n, m);
+
+                if (np->ridged) {
+                    for (int i = 0; i < m; i++) {
+                        seFloat r = 1 - fabsf(n[i]);
+                        sum[i] += amp * r * r;
+                    }
+                } else {
+                    for (int i = 0; i < m; i++)
+                        sum[i] += amp * n[i];
+                }
+                freq *= np->lacunarity;
+                amp *= np->gain;
+            }
+        }
+        return;
+    }
+
+    for (int i = 0; i < count; i++) {
+        seFloat v[3] = { p.x[i], p.y[i], p.z[i] }, g[3];
+
+        out[i] = seFractal(np, v, 3, gradient.x ? g : NULL);
+        if (gradient.x) {
+            gradient.x[i] = g[0];
+            gradient.y[i] = g[1];
+            gradient.z[i] = g[2];
+        }
+    }
+}
+
+/* 
+ * seFractalGrid3:
+ * Fills z slices first..first + count - 1 of a grid of seFractal values
+ * with nx * ny samples per slice, sampled at origin + spacing * (x, y,
+ * z) and stored x-fastest at out[(z * ny + y) * nx + x]. Threads can
+ * each fill their own range of slices (see seBatchRange). Rows go
+ * through seFractal3Batch SE_NOISE_CHUNK samples at a time.
+ * 
+ */
+void seFractalGrid3(const seNoiseParams *np, seVec3 origin, seVec3 spacing, int nx, int ny, int first, int count, seFloat *out)
+{
+    seFloat px[SE_NOISE_CHUNK], py[SE_NOISE_CHUNK], pz[SE_NOISE_CHUNK];
+    seVec3s p, none = { NULL, NULL, NULL };
+    p.x = px;
+    p.y = py;
+    p.z = pz;
+
+    for (int z = first; z < first + count; z++) {
+        for (int y = 0; y < ny; y++) {
+            seFloat *row = out + ((size_t)z * ny + y) * nx;
+
+            for (int x = 0; x < nx; x += SE_NOISE_CHUNK) {
+                int m = nx - x < SE_NOISE_CHUNK ? nx - x : SE_NOISE_CHUNK;
+                for (int i = 0; i < m; i++) {
+                    px[i] = origin.x + spacing.x * (x + i);
+                    py[i] = origin.y + spacing.y * y;
+                    pz[i] = origin.z + spacing.z * z;
+                }
+                seFractal3Batch(np, p, row + x, none, m);
+            }
+        }
+    }
+}
+
+/* Mass Properties */
+
+#ifndef SE_MASS_BLOCK
+#define SE_MASS_BLOCK 1024
+#endif
+
+/* 
+ * seMeshMassBlocks:
+ * Returns the number of fixed-size triangle blocks a mesh is split into
+ * for seMeshMassPartial.
+ * 
+ */
+int seMeshMassBlocks(int triangles)
+{
+    return (triangles + SE_MASS_BLOCK - 1) / SE_MASS_BLOCK;
+}
+
+/* 
+ * seMeshMassPartial:
+ * Integrates the signed tetrahedra between the origin and one block of
+ * SE_MASS_BLOCK triangles of a closed, outward-wound mesh, writing ten
+ * sums (1, x, y, z, x^2, y^2, z^2, xy, yz, zx) to sums.
+ * 
+ * Blocks are independent and may be computed on any thread; since the
+ * block boundaries do not depend on the thread count and
+ * seMeshMassReduce adds them in block order, the result is the same
+ * however the work was split.
+ * 
+ */
+void seMeshMassPartial(const seVec3 *v, const unsigned int *index, int triangles, int block, double *sums)
+{
+    int first = block * SE_MASS_BLOCK;
+    int last = first + SE_MASS_BLOCK < triangles ? first + SE_MASS_BLOCK : triangles;
+    double s[10] = { 0 };
+
+    for (int t = first; t < last; t++) {
+        seVec3 p0 = v[index[3 * t]], p1 = v[index[3 * t + 1]], p2 = v[index[3 * t + 2]];
+        seVec3 d = seV3Cross(seV3Subtract(p1, p0), seV3Subtract(p2, p0));
+        seFloat w[3][3] = { { p0.x, p1.x, p2.x }, { p0.y, p1.y, p2.y }, { p0.z, p1.z, p2.z } };
+        double f1[3], f2[3], f3[3], g[3][3];
+
+        // polynomial subexpressions per axis (Eberly, Polyhedral Mass Properties)
+        for (int a = 0; a < 3; a++) {
+            double w0 = w[a][0], w1 = w[a][1], w2 = w[a][2];
+            double t0 = w0 + w1;
+            double t1 = w0 * w0;
+            double t2 = t1 + w1 * t0;
+            f1[a] = t0 + w2;
+            f2[a] = t2 + w2 * f1[a];
+            f3[a] = w0 * t1 + w1 * t2 + w2 * f2[a];
+            g[a][0] = f2[a] + w0 * (f1[a] + w0);
+            g[a][1] = f2[a] + w1 * (f1[a] + w1);
+            g[a][2] = f2[a] + w2 * (f1[a] + w2);
+        }
+
+        s[0] += d.x * f1[0];
+        s[1] += d.x * f2[0];
+        s[2] += d.y * f2[1];
+        s[3] += d.z * f2[2];
+        s[4] += d.x * f3[0];
+        s[5] += d.y * f3[1];
+        s[6] += d.z * f3[2];
+        s[7] += d.x * (p0.y * g[0][0] + p1.y * g[0][1] + p2.y * g[0][2]);
+        s[8] += d.y * (p0.z * g[1][0] + p1.z * g[1][1] + p2.z * g[1][2]);
+        s[9] += d.z * (p0.x * g[2][0] + p1.x * g[2][1] + p2.x * g[2][2]);
+    }
+
+    memcpy(sums, s, sizeof(s));
+}
+
+/* 
+ * seMeshMassReduce:
+ * Combines the sums of every block, in order and with compensated
+ * summation, into the volume, mass, centroid and inertia tensor about
+ * the centroid of a mesh of uniform density.
+ * 
+ */
+seMassProperties seMeshMassReduce(const double *sums, int blocks, seFloat density)
+{
+    static const double scale[10] = {
+        1.0 / 6, 1.0 / 24, 1.0 / 24, 1.0 / 24, 1.0 / 60,
+        1.0 / 60, 1.0 / 60, 1.0 / 120, 1.0 / 120, 1.0 / 120
+    };
+    double s[10];
+
+    for (int k = 0; k < 10; k++) {
+        double sum = 0, err = 0;
+        for (int b = 0; b < blocks; b++) {
+            double y = sums[b * 10 + k] - err;
+            double t = sum + y;
+            err = (t - sum) - y;
+            sum = t;
+        }
+        s[k] = sum * scale[k];
+    }
+
+    double m = s[0];
+    double cx = m != 0 ? s[1] / m : 0;
+    double cy = m != 0 ? s[2] / m : 0;
+    double cz = m != 0 ? s[3] / m : 0;
+
+    seMassProperties out;
+    out.volume = (seFloat)m;
+    out.mass = (seFloat)(m * density);
+    out.centroid = seV3Assign((seFloat)cx, (seFloat)cy, (seFloat)cz);
+    out.inertia.e[0] = (seFloat)(density * (s[5] + s[6] - m * (cy * cy + cz * cz)));
+    out.inertia.e[4] = (seFloat)(density * (s[4] + s[6] - m * (cz * cz + cx * cx)));
+    out.inertia.e[8] = (seFloat)(density * (s[4] + s[5] - m * (cx * cx + cy * cy)));
+    out.inertia.e[1] = out.inertia.e[3] = (seFloat)(-density * (s[7] - m * cx * cy));
+    out.inertia.e[5] = out.inertia.e[7] = (seFloat)(-density * (s[8] - m * cy * cz));
+    out.inertia.e[2] = out.inertia.e[6] = (seFloat)(-density * (s[9] - m * cz * cx));
+
+    return out;
+}
+
+/* 
+ * seMeshMass:
+ * Returns the mass properties of a closed, outward-wound triangle mesh
+ * of uniform density, computing every block on the calling thread.
+ * 
+ */
+seMassProperties seMeshMass(const seVec3 *v, const unsigned int *index, int triangles, seFloat density)
+{
+    double sums[10], acc[10] = { 0 }, err[10] = { 0 };
+    int blocks = seMeshMassBlocks(triangles);
+
+    // same order and compensation as seMeshMassReduce, without the array
+    for (int b = 0; b < blocks; b++) {
+        seMeshMassPartial(v, index, triangles, b, sums);
+        for (int k = 0; k < 10; k++) {
+            double y = sums[k] - err[k];
+            double t = acc[k] + y;
+            err[k] = (t - acc[k]) - y;
+            acc[k] = t;
+        }
+    }
+
+    return seMeshMassReduce(acc, 1, density);
+}
+
+/* Closest Points */
+
+/* 
+ * seV3ClosestSegment:
+ * Returns the point on segment ab closest to p, and writes its
+ * parameter along the segment (0 at a, 1 at b) to t if not NULL.
+ * 
+ */
+seVec3 seV3ClosestSegment(seVec3 p, seVec3 a, seVec3 b, seFloat *t)
+{
+    seVec3 ab = seV3Subtract(b, a);
+    seFloat len = seV3Dot(ab, ab);
+    seFloat s = len > 0 ? seV3Dot(seV3Subtract(p, a), ab) / len : 0;
+    s = fminf(fmaxf(s, 0), 1);
+
+    if (t)
+        *t = s;
+    return seV3Assign(a.x + ab.x * s, a.y + ab.y * s, a.z + ab.z * s);
+}
+
+/* 
+ * seV3ClosestTriangle:
+ * Returns the point on triangle abc closest to p, and writes its
+ * barycentric coordinates (weights of a, b and c) to bary if not NULL.
+ * Walks the Voronoi regions of the vertices and edges as in Ericson,
+ * Real-Time Collision Detection, 5.1.5.
+ * 
+ */
+seVec3 seV3ClosestTriangle(seVec3 p, seVec3 a, seVec3 b, seVec3 c, seVec3 *bary)
+{
+    seVec3 ab = seV3Subtract(b, a);
+    seVec3 ac = seV3Subtract(c, a);
+    seVec3 ap = seV3Subtract(p, a);
+    seFloat d1 = seV3Dot(ab, ap);
+    seFloat d2 = seV3Dot(ac, ap);
+    seFloat u, v, w;
+
+    seVec3 bp = seV3Subtract(p, b);
+    seFloat d3 = seV3Dot(ab, bp);
+    seFloat d4 = seV3Dot(ac, bp);
+
+    seVec3 cp = seV3Subtract(p, c);
+    seFloat d5 = seV3Dot(ab, cp);
+    seFloat d6 = seV3Dot(ac, cp);
+
+    seFloat va = d3 * d6 - d5 * d4;
+    seFloat vb = d5 * d2 - d1 * d6;
+    seFloat vc = d1 * d4 - d3 * d2;
+
+    if (d1 <= 0 && d2 <= 0) {
+        u = 1; v = 0; w = 0;
+    } else if (d3 >= 0 && d4 <= d3) {
+        u = 0; v = 1; w = 0;
+    } else if (d6 >= 0 && d5 <= d6) {
+        u = 0; v = 0; w = 1;
+    } else if (vc <= 0 && d1 >= 0 && d3 <= 0) {
+        v = d1 / (d1 - d3);
+        u = 1 - v; w = 0;
+    } else if (vb <= 0 && d2 >= 0 && d6 <= 0) {
+        w = d2 / (d2 - d6);
+        u = 1 - w; v = 0;
+    } else if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0) {
+        w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        v = 1 - w; u = 0;
+    } else {
+        seFloat denom = 1 / (va + vb + vc);
+        v = vb * denom;
+        w = vc * denom;
+        u = 1 - v - w;
+    }
+
+    if (bary)
+        *bary = seV3Assign(u, v, w);
+    return seV3Assign(a.x * u + b.x * v + c.x * w,
+                      a.y * u + b.y * v + c.y * w,
+                      a.z * u + b.z * v + c.z * w);
+}
+
+/* 
+ * seV3ClosestOBB:
+ * Returns the point in or on an oriented box closest to p.
+ * 
+ */
+seVec3 seV3ClosestOBB(seVec3 p, const seOBB *box)
+{
+    seVec3 d = seV3Subtract(p, box->center);
+    seFloat e[3] = { box->extent.x, box->extent.y, box->extent.z };
+    seVec3 out = box->center;
+
+    for (int i = 0; i < 3; i++) {
+        seFloat s = fminf(fmaxf(seV3Dot(d, box->axis[i]), -e[i]), e[i]);
+        out.x += box->axis[i].x * s;
+        out.y += box->axis[i].y * s;
+        out.z += box->axis[i].z * s;
+    }
+
+    return out;
+}
+
+/* 
+ * seV3ClosestSegmentBatch:
+ * Finds the closest points on one segment to count query points,
+ * writing them to out and their distances to distance if not NULL.
+ * The loop is branch-free so it vectorizes across queries.
+ * 
+ */
+void seV3ClosestSegmentBatch(seVec3s p, seVec3 a, seVec3 b, seVec3s out, seFloat *distance, int count)
+{
+    seVec3 ab = seV3Subtract(b, a);
+    seFloat len = seV3Dot(ab, ab);
+    seFloat inv = len > 0 ? 1 / len : 0;
+
+    for (int i = 0; i < count; i++) {
+        seFloat dx = p.x[i] - a.x, dy = p.y[i] - a.y, dz = p.z[i] - a.z;
+        seFloat s = fminf(fmaxf((dx * ab.x + dy * ab.y + dz * ab.z) * inv, 0), 1);
+        seFloat rx = ab.x * s - dx, ry = ab.y * s - dy, rz = ab.z * s - dz;
+        if (distance)
+            distance[i] = sqrtf(rx * rx + ry * ry + rz * rz);
+        out.x[i] = p.x[i] + rx;
+        out.y[i] = p.y[i] + ry;
+        out.z[i] = p.z[i] + rz;
+    }
+}
+
+/* 
+ * seV3ClosestTriangleBatch:
+ * Finds the closest points on one triangle to count query points. The
+ * Voronoi region walk branches per query, so this runs one query at a
+ * time.
+ * 
+ */
+void seV3ClosestTriangleBatch(seVec3s p, seVec3 a, seVec3 b, seVec3 c, seVec3s out, seFloat *distance, int count)
+{
+    for (int i = 0; i < count; i++) {
+        seVec3 q = seV3Assign(p.x[i], p.y[i], p.z[i]);
+        seVec3 r = seV3ClosestTriangle(q, a, b, c, NULL);
+        out.x[i] = r.x;
+        out.y[i] = r.y;
+        out.z[i] = r.z;
+        if (distance)
+            distance[i] = seV3Length(seV3Subtract(q, r));
+    }
+}
+
+/* 
+ * seV3ClosestOBBBatch:
+ * Finds the closest points in one oriented box to count query points.
+ * The loop is branch-free so it vectorizes across queries.
+ * 
+ */
+void seV3ClosestOBBBatch(seVec3s p, const seOBB *box, seVec3s out, seFloat *distance, int count)
+{
+    seVec3 c = box->center, u = box->axis[0], v = box->axis[1], w = box->axis[2];
+    seVec3 e = box->extent;
+
+    for (int i = 0; i < count; i++) {
+        seFloat dx = p.x[i] - c.x, dy = p.y[i] - c.y, dz = p.z[i] - c.z;
+        seFloat su = fminf(fmaxf(dx * u.x + dy * u.y + dz * u.z, -e.x), e.x);
+        seFloat sv = fminf(fmaxf(dx * v.x + dy * v.y + dz * v.z, -e.y), e.y);
+        seFloat sw = fminf(fmaxf(dx * w.x + dy * w.y + dz * w.z, -e.z), e.z);
+        seFloat rx = u.x * su + v.x * sv + w.x * sw;
+        seFloat ry = u.y * su + v.y * sv + w.y * sw;
+        seFloat rz = u.z * su + v.z * sv + w.z * sw;
+        if (distance) {
+            seFloat ex = rx - dx, ey = ry - dy, ez = rz - dz;
+            distance[i] = sqrtf(ex * ex + ey * ey + ez * ez);
+        }
+        out.x[i] = c.x + rx;
+        out.y[i] = c.y + ry;
+        out.z[i] = c.z + rz;
+    }
+}
+
+/* 
+ * seBVHSplit:
+ * Fits node n around its triangles and, if it holds more than a few,
+ * splits them at the middle of the largest centroid extent into two
+ * new child nodes.
+ * 
+ */
+void seBVHSplit(seBVH *bvh, int n, int first, int count)
+{
+    seVec3 lo = seV3Assign(INFINITY, INFINITY, INFINITY), hi = seV3Assign(-INFINITY, -INFINITY, -INFINITY);
+    seVec3 clo = lo, chi = hi;
+
+    for (int i = first; i < first + count; i++) {
+        const unsigned int *t = bvh->index + 3 * bvh->order[i];
+        seVec3 c = seV3Assign(0, 0, 0);
+        for (int k = 0; k < 3; k++) {
+            seVec3 p = bvh->v[t[k]];
+            lo = seV3Assign(fminf(lo.x, p.x), fminf(lo.y, p.y), fminf(lo.z, p.z));
+            hi = seV3Assign(fmaxf(hi.x, p.x), fmaxf(hi.y, p.y), fmaxf(hi.z, p.z));
+            c = seV3Add(c, p);
+        }
+        clo = seV3Assign(fminf(clo.x, c.x), fminf(clo.y, c.y), fminf(clo.z, c.z));
+        chi = seV3Assign(fmaxf(chi.x, c.x), fmaxf(chi.y, c.y), fmaxf(chi.z, c.z));
+    }
+
+    seBVHNode *node = &bvh->nodes[n];
+    node->min = lo;
+    node->max = hi;
+    node->first = first;
+    node->count = count;
+    node->leaf = 1;
+    if (count <= 4)
+        return;
+
+    // centroids are kept as vertex sums, so split at the summed midpoint
+    seVec3 ext = seV3Subtract(chi, clo);
+    int axis = (ext.x >= ext.y && ext.x >= ext.z) ? 0 : (ext.y >= ext.z ? 1 : 2);
+    seFloat mid = axis == 0 ? (clo.x + chi.x) / 2 : axis == 1 ? (clo.y + chi.y) / 2 : (clo.z + chi.z) / 2;
+
+    int split = first;
+    for (int i = first; i < first + count; i++) {
+        const unsigned int *t = bvh->index + 3 * bvh->order[i];
+        seVec3 c = seV3Add(seV3Add(bvh->v[t[0]], bvh->v[t[1]]), bvh->v[t[2]]);
+        seFloat k = axis == 0 ? c.x : axis == 1 ? c.y : c.z;
+        if (k < mid) {
+            unsigned int tmp = bvh->order[i];
+            bvh->order[i] = bvh->order[split];
+            bvh->order[split++] = tmp;
+        }
+    }
+    // keep the tree shallow enough for the fixed traversal stack
+    if (split - first < count / 4 || first + count - split < count / 4)
+        split = first + count / 2;
+
+    int child = bvh->count;
+    bvh->count += 2;
+    node->first = child;
+    node->count = 0;
+    node->leaf = 0;
+    seBVHSplit(bvh, child, first, split - first);
+    seBVHSplit(bvh, child + 1, split, first + count - split);
+}
+
+/* 
+ * seBVHBuild:
+ * Builds a BVH over the triangles of an indexed mesh. nodes must have
+ * room for 2 * triangles nodes and order for triangles entries; the
+ * mesh arrays are referenced, not copied. Returns the number of nodes
+ * used, which is 0 for an empty mesh.
+ * 
+ */
+int seBVHBuild(seBVH *bvh, const seVec3 *v, const unsigned int *index, int triangles, seBVHNode *nodes, unsigned int *order)
+{
+    bvh->v = v;
+    bvh->index = index;
+    bvh->nodes = nodes;
+    bvh->order = order;
+    bvh->count = 0;
+    if (triangles <= 0)
+        return 0;
+
+    bvh->count = 1;
+    for (int i = 0; i < triangles; i++)
+        order[i] = i;
+    seBVHSplit(bvh, 0, 0, triangles);
+
+    return bvh->count;
+}
+
+/* 
+ * seBVHBoxDistance:
+ * Returns the squared distance from a point to a BVH node's box.
+ * 
+ */
+seFloat seBVHBoxDistance(const seBVHNode *node, seVec3 p)
+{
+    seFloat dx = fmaxf(fmaxf(node->min.x - p.x, p.x - node->max.x), 0);
+    seFloat dy = fmaxf(fmaxf(node->min.y - p.y, p.y - node->max.y), 0);
+    seFloat dz = fmaxf(fmaxf(node->min.z - p.z, p.z - node->max.z), 0);
+
+    return dx * dx + dy * dy + dz * dz;
+}
+
+/* 
+ * seBVHClosest:
+ * Finds the point of the mesh closest to p within maxDistance. Returns
+ * the triangle index, or -1 if nothing is that close or the mesh is
+ * empty, and writes the point, its barycentric coordinates and its
+ * distance to any of point, bary and distance that are not NULL.
+ * 
+ * The quarter-split rule in seBVHSplit keeps trees over up to 2^31
+ * triangles under 72 levels, well inside the traversal stack.
+ * 
+ */
+int seBVHClosest(const seBVH *bvh, seVec3 p, seFloat maxDistance, seVec3 *point, seVec3 *bary, seFloat *distance)
+{
+    int stack[96];
+    int top = 0;
+    int best = -1;
+    seFloat bestDist = maxDistance * maxDistance;
+    seVec3 bestPoint = p, bestBary = seV3Assign(0, 0, 0);
+
+    if (bvh->count > 0)
+        stack[top++] = 0;
+    while (top) {
+        const seBVHNode *node = &bvh->nodes[stack[--top]];
+        if (seBVHBoxDistance(node, p) > bestDist)
+            continue;
+
+        if (node->leaf) {
+            for (int i = node->first; i < node->first + node->count; i++) {
+                const unsigned int *t = bvh->index + 3 * bvh->order[i];
+                seVec3 b;
+                seVec3 c = seV3ClosestTriangle(p, bvh->v[t[0]], bvh->v[t[1]], bvh->v[t[2]], &b);
+                seVec3 d = seV3Subtract(p, c);
+                seFloat dist = seV3Dot(d, d);
+                if (dist <= bestDist) {
+                    bestDist = dist;
+                    best = bvh->order[i];
+                    bestPoint = c;
+                    bestBary = b;
+                }
+            }
+            continue;
+        }
+
+        // visit the nearer child first by pushing it last
+        int l = node->first, r = node->first + 1;
+        if (seBVHBoxDistance(&bvh->nodes[l], p) < seBVHBoxDistance(&bvh->nodes[r], p)) {
+            int tmp = l;
+            l = r;
+            r = tmp;
+        }
+        // never write past the stack; the depth bound above makes this
+        // unreachable for trees built by seBVHBuild
+        if (top + 2 > (int)(sizeof(stack) / sizeof(stack[0])))
+            break;
+        stack[top++] = l;
+        stack[top++] = r;
+    }
+
+    if (point)
+        *point = bestPoint;
+    if (bary)
+        *bary = bestBary;
+    if (distance)
+        *distance = sqrtf(bestDist);
+    return best;
+}
+
+/* Robust Predicates */
+
+/* 
+ * seExpSum:
+ * Adds two floating-point expansions (sums of nonoverlapping doubles in
+ * increasing magnitude) exactly, writing the result to h, which must
+ * have room for elen + flen components. Returns the length of h; zero
+ * components are dropped. Follows Shewchuk, Adaptive Precision
+ * Floating-Point Arithmetic and Fast Robust Geometric Predicates.
+ * 
+ * These routines rely on strict IEEE double rounding; do not build them
+ * with -ffast-math or x87 extended precision.
+ * 
+ */
+int seExpSum(const double *e, int elen, const double *f, int flen, double *h)
+{
+    int i = 0, j = 0, n = 0;
+    double q, x, y, bv;
+
+    // take the smaller magnitude component next, as in a merge
+    if (j >= flen || (i < elen && fabs(e[i]) <= fabs(f[j])))
+        q = e[i++];
+    else
+        q = f[j++];
+
+    while (i < elen || j < flen) {
+        double b;
+        if (j >= flen || (i < elen && fabs(e[i]) <= fabs(f[j])))
+            b = e[i++];
+        else
+            b = f[j++];
+
+        x = q + b;
+        bv = x - q;
+        y = (q - (x - bv)) + (b - bv);
+        q = x;
+        if (y != 0)
+            h[n++] = y;
+    }
+
+    if (q != 0 || n == 0)
+        h[n++] = q;
+    return n;
+}
+
+/* 
+ * seExpScale:
+ * Multiplies an expansion by a double exactly, writing at most 2 * elen
+ * components to h. Returns the length of h.
+ * 
+ */
+int seExpScale(const double *e, int elen, double b, double *h)
+{
+    int n = 0;
+    double q = e[0] * b;
+    double y = fma(e[0], b, -q);
+    if (y != 0)
+        h[n++] = y;
+
+    for (int i = 1; i < elen; i++) {
+        double p1 = e[i] * b;
+        double p0 = fma(e[i], b, -p1);
+        double sum = q + p0;
+        double bv = sum - q;
+        y = (q - (sum - bv)) + (p0 - bv);
+        if (y != 0)
+            h[n++] = y;
+        q = p1 + sum;
+        y = sum - (q - p1);
+        if (y != 0)
+            h[n++] = y;
+    }
+
+    if (q != 0 || n == 0)
+        h[n++] = q;
+    return n;
+}
+
+/* 
+ * seExpCross:
+ * Writes ax * by - bx * ay exactly to h (at most 4 components) and
+ * returns its length.
+ * 
+ */
+int seExpCross(double ax, double ay, double bx, double by, double *h)
+{
+    double p = ax * by, q = bx * ay;
+    double e[2] = { fma(ax, by, -p), p };
+    double f[2] = { -fma(bx, ay, -q), -q };
+
+    return seExpSum(e, 2, f, 2, h);
+}
+
+/* 
+ * seExpOrient2D:
+ * Writes the exact determinant |px py 1; qx qy 1; rx ry 1| to h (at
+ * most 12 components) and returns its length.
+ * 
+ */
+int seExpOrient2D(seVec3 p, seVec3 q, seVec3 r, double *h)
+{
+    double pq[4], qr[4], rp[4], t[8];
+    int a = seExpCross(p.x, p.y, q.x, q.y, pq);
+    int b = seExpCross(q.x, q.y, r.x, r.y, qr);
+    int c = seExpCross(r.x, r.y, p.x, p.y, rp);
+    int n = seExpSum(pq, a, qr, b, t);
+
+    return seExpSum(t, n, rp, c, h);
+}
+
+/* 
+ * seExpOrient3D:
+ * Writes the exact 4x4 determinant that decides seOrient3D, expanded
+ * from the raw coordinates, to h (at most 96 components) and returns
+ * its length.
+ * 
+ */
+int seExpOrient3D(seVec3 p, seVec3 q, seVec3 r, seVec3 s, double *h)
+{
+    seVec3 pt[4] = { p, q, r, s };
+    double m[4][24], t[48], u[48];
+    int mlen[4];
+
+    // minor k leaves out point k; the ones column alternates its sign
+    for (int k = 0; k < 4; k++) {
+        seVec3 a, b, c;
+        double ab[4], bc[4], ca[4], s1[8], s2[8], s3[8], s12[16];
+        a = pt[k == 0 ? 1 : 0];
+        b = pt[k <= 1 ? 2 : 1];
+        c = pt[k <= 2 ? 3 : 2];
+
+        int n1 = seExpCross(b.x, b.y, c.x, c.y, bc);
+        int n2 = seExpCross(c.x, c.y, a.x, a.y, ca);
+        int n3 = seExpCross(a.x, a.y, b.x, b.y, ab);
+        n1 = seExpScale(bc, n1, (k % 2) ? a.z : -a.z, s1);
+        n2 = seExpScale(ca, n2, (k % 2) ? b.z : -b.z, s2);
+        n3 = seExpScale(ab, n3, (k % 2) ? c.z : -c.z, s3);
+        int n12 = seExpSum(s1, n1, s2, n2, s12);
+        mlen[k] = seExpSum(s12, n12, s3, n3, m[k]);
+    }
+
+    int n = seExpSum(m[0], mlen[0], m[1], mlen[1], t);
+    int o = seExpSum(m[2], mlen[2], m[3], mlen[3], u);
+    return seExpSum(t, n, u, o, h);
+}
+
+/* 
+ * seExpLift:
+ * Multiplies an expansion by the squared length of p over its first
+ * dims coordinates, and by sign (1 or -1), writing at most
+ * 4 * dims * elen components to h. work must have room for
+ * (6 + 4 * dims) * elen doubles. Returns the length.
+ * 
+ */
+int seExpLift(const double *e, int elen, seVec3 p, int dims, double sign, double *h, double *work)
+{
+    double c[3] = { p.x, p.y, p.z };
+    double *t = work, *s = t + 2 * elen, *sum = s + 4 * elen;
+    int n = 0;
+
+    for (int k = 0; k < dims; k++) {
+        int m = seExpScale(e, elen, c[k] * sign, t);
+        m = seExpScale(t, m, c[k], s);
+        if (k == 0) {
+            memcpy(h, s, m * sizeof(double));
+            n = m;
+        } else {
+            n = seExpSum(h, n, s, m, sum);
+            memcpy(h, sum, n * sizeof(double));
+        }
+    }
+
+    return n;
+}
+
+/* 
+ * seOrient2DExact:
+ * Returns the exact sign of seOrient2D.
+ * 
+ */
+int seOrient2DExact(seVec3 a, seVec3 b, seVec3 c)
+{
+    double h[12];
+    int n = seExpOrient2D(a, b, c, h);
+
+    return (h[n - 1] > 0) - (h[n - 1] < 0);
+}
+
+/* 
+ * seOrient3DExact:
+ * Returns the exact sign of seOrient3D.
+ * 
+ */
+int seOrient3DExact(seVec3 a, seVec3 b, seVec3 c, seVec3 d)
+{
+    double h[96];
+    int n = seExpOrient3D(a, b, c, d, h);
+
+    return (h[n - 1] > 0) - (h[n - 1] < 0);
+}
+
+/* 
+ * seInCircleExact:
+ * Returns the exact sign of seInCircle.
+ * 
+ */
+int seInCircleExact(seVec3 a, seVec3 b, seVec3 c, seVec3 d)
+{
+    seVec3 pt[4] = { a, b, c, d };
+    double e[12], l[96], acc[384], sum[384], work[168];
+    int n = 0;
+
+    for (int k = 0; k < 4; k++) {
+        seVec3 p = pt[k == 0 ? 1 : 0];
+        seVec3 q = pt[k <= 1 ? 2 : 1];
+        seVec3 r = pt[k <= 2 ? 3 : 2];
+        int m = seExpOrient2D(p, q, r, e);
+        m = seExpLift(e, m, pt[k], 2, (k % 2) ? 1 : -1, l, work);
+        if (k == 0) {
+            memcpy(acc, l, m * sizeof(double));
+            n = m;
+        } else {
+            n = seExpSum(acc, n, l, m, sum);
+            memcpy(acc, sum, n * sizeof(double));
+        }
+    }
+
+    return (acc[n - 1] < 0) - (acc[n - 1] > 0);
+}
+
+/* 
+ * seInSphereExact:
+ * Returns the exact sign of seInSphere. The worst-case expansions take
+ * about 113KB, so they live in caller-owned scratch of
+ * SE_INSPHERE_SCRATCH doubles rather than on the stack.
+ * 
+ */
+int seInSphereExact(seVec3 a, seVec3 b, seVec3 c, seVec3 d, seVec3 e, double *scratch)
+{
+    seVec3 pt[5] = { a, b, c, d, e };
+    double *o = scratch, *l = o + 96, *work = l + 1152, *acc = work + 1728, *sum = acc + 5760;
+    int n = 0;
+
+    for (int k = 0; k < 5; k++) {
+        seVec3 r[4];
+        for (int i = 0, j = 0; i < 5; i++)
+            if (i != k)
+                r[j++] = pt[i];
+
+        int m = seExpOrient3D(r[0], r[1], r[2], r[3], o);
+        m = seExpLift(o, m, pt[k], 3, (k % 2) ? -1 : 1, l, work);
+        if (k == 0) {
+            memcpy(acc, l, m * sizeof(double));
+            n = m;
+        } else {
+            n = seExpSum(acc, n, l, m, sum);
+            memcpy(acc, sum, n * sizeof(double));
+        }
+    }
+
+    return (acc[n - 1] < 0) - (acc[n - 1] > 0);
+}
+
+/* 
+ * seOrient2DFilter:
+ * Evaluates seOrient2D in double and returns its sign, or
+ * SE_SIGN_UNSURE when the determinant is within the rounding error
+ * bound of zero. Branch-free, so loops over it vectorize.
+ * 
+ */
+int seOrient2DFilter(seVec3 a, seVec3 b, seVec3 c)
+{
+    double left = ((double)a.x - c.x) * ((double)b.y - c.y);
+    double right = ((double)a.y - c.y) * ((double)b.x - c.x);
+    double det = left - right;
+    double bound = 3.3306690738754716e-16 * (fabs(left) + fabs(right));
+
+    return det > bound ? 1 : -det > bound ? -1 : SE_SIGN_UNSURE;
+}
+
+/* 
+ * seOrient3DFilter:
+ * Like seOrient2DFilter, for seOrient3D.
+ * 
+ */
+int seOrient3DFilter(seVec3 a, seVec3 b, seVec3 c, seVec3 d)
+{
+    double adx = (double)a.x - d.x, ady = (double)a.y - d.y, adz = (double)a.z - d.z;
+    double bdx = (double)b.x - d.x, bdy = (double)b.y - d.y, bdz = (double)b.z - d.z;
+    double cdx = (double)c.x - d.x, cdy = (double)c.y - d.y, cdz = (double)c.z - d.z;
+    double bc = bdx * cdy, cb = cdx * bdy;
+    double ca = cdx * ady, ac = adx * cdy;
+    double ab = adx * bdy, ba = bdx * ady;
+
+    double det = adz * (bc - cb) + bdz * (ca - ac) + cdz * (ab - ba);
+    double permanent = (fabs(bc) + fabs(cb)) * fabs(adz) +
+                       (fabs(ca) + fabs(ac)) * fabs(bdz) +
+                       (fabs(ab) + fabs(ba)) * fabs(cdz);
+    double bound = 7.7715611723761027e-16 * permanent;
+
+    return det > bound ? 1 : -det > bound ? -1 : SE_SIGN_UNSURE;
+}
+
+/* 
+ * seInCircleFilter:
+ * Like seOrient2DFilter, for seInCircle.
+ * 
+ */
+int seInCircleFilter(seVec3 a, seVec3 b, seVec3 c, seVec3 d)
+{
+    double adx = (double)a.x - d.x, ady = (double)a.y - d.y;
+    double bdx = (double)b.x - d.x, bdy = (double)b.y - d.y;
+    double cdx = (double)c.x - d.x, cdy = (double)c.y - d.y;
+    double bc = bdx * cdy, cb = cdx * bdy;
+    double ca = cdx * ady, ac = adx * cdy;
+    double ab = adx * bdy, ba = bdx * ady;
+    double alift = adx * adx + ady * ady;
+    double blift = bdx * bdx + bdy * bdy;
+    double clift = cdx * cdx + cdy * cdy;
+
+    double det = alift * (bc - cb) + blift * (ca - ac) + clift * (ab - ba);
+    double permanent = (fabs(bc) + fabs(cb)) * alift +
+                       (fabs(ca) + fabs(ac)) * blift +
+                       (fabs(ab) + fabs(ba)) * clift;
+    double bound = 1.1102230246251577e-15 * permanent;
+
+    return det > bound ? 1 : -det > bound ? -1 : SE_SIGN_UNSURE;
+}
+
+/* 
+ * seInSphereFilter:
+ * Like seOrient2DFilter, for seInSphere.
+ * 
+ */
+int seInSphereFilter(seVec3 a, seVec3 b, seVec3 c, seVec3 d, seVec3 e)
+{
+    double aex = (double)a.x - e.x, aey = (double)a.y - e.y, aez = (double)a.z - e.z;
+    double bex = (double)b.x - e.x, bey = (double)b.y - e.y, bez = (double)b.z - e.z;
+    double cex = (double)c.x - e.x, cey = (double)c.y - e.y, cez = (double)c.z - e.z;
+    double dex = (double)d.x - e.x, dey = (double)d.y - e.y, dez = (double)d.z - e.z;
+    double aexbey = aex * bey, bexaey = bex * aey;
+    double bexcey = bex * cey, cexbey = cex * bey;
+    double cexdey = cex * dey, dexcey = dex * cey;
+    double dexaey = dex * aey, aexdey = aex * dey;
+    double aexcey = aex * cey, cexaey = cex * aey;
+    double bexdey = bex * dey, dexbey = dex * bey;
+    double ab = aexbey - bexaey, bc = bexcey - cexbey, cd = cexdey - dexcey;
+    double da = dexaey - aexdey, ac = aexcey - cexaey, bd = bexdey - dexbey;
+    double abc = aez * bc - bez * ac + cez * ab;
+    double bcd = bez * cd - cez * bd + dez * bc;
+    double cda = cez * da + dez * ac + aez * cd;
+    double dab = dez * ab + aez * bd + bez * da;
+    double alift = aex * aex + aey * aey + aez * aez;
+    double blift = bex * bex + bey * bey + bez * bez;
+    double clift = cex * cex + cey * cey + cez * cez;
+    double dlift = dex * dex + dey * dey + dez * dez;
+
+    double det = (dlift * abc - clift * dab) + (blift * cda - alift * bcd);
+
+    double az = fabs(aez), bz = fabs(bez), cz = fabs(cez), dz = fabs(dez);
+    double pab = fabs(aexbey) + fabs(bexaey), pbc = fabs(bexcey) + fabs(cexbey);
+    double pcd = fabs(cexdey) + fabs(dexcey), pda = fabs(dexaey) + fabs(aexdey);
+    double pac = fabs(aexcey) + fabs(cexaey), pbd = fabs(bexdey) + fabs(dexbey);
+    double permanent = (pcd * bz + pbd * cz + pbc * dz) * alift +
+                       (pda * cz + pac * dz + pcd * az) * blift +
+                       (pab * dz + pbd * az + pda * bz) * clift +
+                       (pbc * az + pac * bz + pab * cz) * dlift;
+    double bound = 1.7763568394002532e-15 * permanent;
+
+    return det > bound ? 1 : -det > bound ? -1 : SE_SIGN_UNSURE;
+}
+
+/* 
+ * seOrient2D:
+ * Returns 1 if a, b and c (x and y only) are in counterclockwise order,
+ * -1 if clockwise and 0 if collinear. The determinant is computed in
+ * double and only falls back to exact arithmetic when it is within
+ * the rounding error bound of zero.
+ * 
+ */
+int seOrient2D(seVec3 a, seVec3 b, seVec3 c)
+{
+    int sign = seOrient2DFilter(a, b, c);
+
+    return sign != SE_SIGN_UNSURE ? sign : seOrient2DExact(a, b, c);
+}
+
+/* 
+ * seOrient3D:
+ * Returns 1 if d lies below the plane through a, b and c, which appear
+ * counterclockwise when seen from above; -1 if above and 0 if coplanar.
+ * 
+ */
+int seOrient3D(seVec3 a, seVec3 b, seVec3 c, seVec3 d)
+{
+    int sign = seOrient3DFilter(a, b, c, d);
+
+    return sign != SE_SIGN_UNSURE ? sign : seOrient3DExact(a, b, c, d);
+}
+
+/* 
+ * seInCircle:
+ * Returns 1 if d (x and y only) lies inside the circle through a, b and
+ * c, which must be in counterclockwise order; -1 if outside and 0 if on
+ * the circle.
+ * 
+ */
+int seInCircle(seVec3 a, seVec3 b, seVec3 c, seVec3 d)
+{
+    int sign = seInCircleFilter(a, b, c, d);
+
+    return sign != SE_SIGN_UNSURE ? sign : seInCircleExact(a, b, c, d);
+}
+
+/* 
+ * seInSphere:
+ * Returns 1 if e lies inside the sphere through a, b, c and d, which
+ * must be positively oriented (seOrient3D(a, b, c, d) > 0); -1 if
+ * outside and 0 if on the sphere. scratch (SE_INSPHERE_SCRATCH doubles)
+ * is only touched when the exact fallback runs.
+ * 
+ */
+int seInSphere(seVec3 a, seVec3 b, seVec3 c, seVec3 d, seVec3 e, double *scratch)
+{
+    int sign = seInSphereFilter(a, b, c, d, e);
+
+    return sign != SE_SIGN_UNSURE ? sign : seInSphereExact(a, b, c, d, e, scratch);
+}
+
+/* 
+ * seOrient2DBatch:
+ * Classifies count points against the directed line from a to b, as
+ * seOrient2D(a, b, c[i]). The filter runs over every lane first, and
+ * only the lanes it leaves open are evaluated exactly.
+ * 
+ */
+void seOrient2DBatch(seVec3 a, seVec3 b, seVec3s c, int *sign, int count)
+{
+    for (int i = 0; i < count; i++)
+        sign[i] = seOrient2DFilter(a, b, seV3Assign(c.x[i], c.y[i], 0));
+    for (int i = 0; i < count; i++)
+        if (sign[i] == SE_SIGN_UNSURE)
+            sign[i] = seOrient2DExact(a, b, seV3Assign(c.x[i], c.y[i], 0));
+}
+
+/* 
+ * seOrient3DBatch:
+ * Classifies count points against the plane through a, b and c, as
+ * seOrient3D(a, b, c, d[i]), filtering all lanes before any exact
+ * fallback.
+ * 
+ */
+void seOrient3DBatch(seVec3 a, seVec3 b, seVec3 c, seVec3s d, int *sign, int count)
+{
+    for (int i = 0; i < count; i++)
+        sign[i] = seOrient3DFilter(a, b, c, seV3Assign(d.x[i], d.y[i], d.z[i]));
+    for (int i = 0; i < count; i++)
+        if (sign[i] == SE_SIGN_UNSURE)
+            sign[i] = seOrient3DExact(a, b, c, seV3Assign(d.x[i], d.y[i], d.z[i]));
+}
+
+/* 
+ * seInCircleBatch:
+ * Classifies count points against the circle through a, b and c, as
+ * seInCircle(a, b, c, d[i]), filtering all lanes before any exact
+ * fallback.
+ * 
+ */
+void seInCircleBatch(seVec3 a, seVec3 b, seVec3 c, seVec3s d, int *sign, int count)
+{
+    for (int i = 0; i < count; i++)
+        sign[i] = seInCircleFilter(a, b, c, seV3Assign(d.x[i], d.y[i], 0));
+    for (int i = 0; i < count; i++)
+        if (sign[i] == SE_SIGN_UNSURE)
+            sign[i] = seInCircleExact(a, b, c, seV3Assign(d.x[i], d.y[i], 0));
+}
+
+/* 
+ * seInSphereBatch:
+ * Classifies count points against the sphere through a, b, c and d, as
+ * seInSphere(a, b, c, d, e[i], scratch), filtering all lanes before
+ * any exact fallback.
+ * 
+ */
+void seInSphereBatch(seVec3 a, seVec3 b, seVec3 c, seVec3 d, seVec3s e, int *sign, int count, double *scratch)
+{
+    for (int i = 0; i < count; i++)
+        sign[i] = seInSphereFilter(a, b, c, d, seV3Assign(e.x[i], e.y[i], e.z[i]));
+    for (int i = 0; i < count; i++)
+        if (sign[i] == SE_SIGN_UNSURE)
+            sign[i] = seInSphereExact(a, b, c, d, seV3Assign(e.x[i], e.y[i], e.z[i]), scratch);
+}
+
+/* Mesh Optimization */
+
+/* 
+ * seMeshCacheStats:
+ * Simulates a FIFO post-transform vertex cache of cacheSize entries
+ * over an indexed triangle list and returns the number of misses
+ * (vertex shader invocations). Writes the average cache miss ratio
+ * (misses per triangle) to acmr and the average transform to vertex
+ * ratio (misses per referenced vertex, 1 is optimal) to atvr, either
+ * of which may be NULL. Scratch must hold vertices unsigned ints.
+ * 
+ */
+int seMeshCacheStats(const unsigned int *index, int triangles, int vertices, int cacheSize, unsigned int *scratch, seFloat *acmr, seFloat *atvr)
+{
+    // a vertex is cached if it entered the FIFO less than cacheSize
+    // insertions ago; time starts past cacheSize so 0 means never
+    unsigned int time = cacheSize + 1;
+    int misses = 0, used = 0;
+
+    memset(scratch, 0, vertices * sizeof(*scratch));
+    for (int i = 0; i < 3 * triangles; i++) {
+        unsigned int v = index[i];
+        if (time - scratch[v] > (unsigned int)cacheSize) {
+            used += scratch[v] == 0;
+            scratch[v] = time++;
+            misses++;
+        }
+    }
+
+    if (acmr)
+        *acmr = triangles > 0 ? (seFloat)misses / triangles : 0;
+    if (atvr)
+        *atvr = used > 0 ? (seFloat)misses / used : 0;
+    return misses;
+}
+
+/* 
+ * seMeshOptimizeCacheScratch:
+ * Returns the number of unsigned ints of scratch seMeshOptimizeCache
+ * needs for a mesh of the given size.
+ * 
+ */
+int seMeshOptimizeCacheScratch(int triangles, int vertices)
+{
+    return 3 * vertices + 7 * triangles + 1;
+}
+
+/* 
+ * seMeshOptimizeCache:
+ * Reorders triangles for post-transform vertex cache locality using
+ * Tipsify (Sander, Nehab and Barczak, Fast Triangle Reordering for
+ * Vertex Locality and Reduced Overdraw, 2007), writing the new index
+ * list to out, which must not alias index. Runs in linear time.
+ * 
+ * The start of every run that begins after a dead end (where no vertex
+ * of the last fan has triangles left) is written to clusters, followed by a final
+ * entry of triangles, and the number of runs is returned; clusters
+ * needs room for triangles + 1 entries and may be NULL. These are the
+ * hard boundaries seMeshClusterSplit and seMeshOptimizeOverdraw work
+ * with. Scratch is sized by seMeshOptimizeCacheScratch.
+ * 
+ */
+int seMeshOptimizeCache(const unsigned int *index, int triangles, int vertices, int cacheSize, unsigned int *out, unsigned int *clusters, unsigned int *scratch)
+{
+    unsigned int *offset = scratch;                     // vertices + 1
+    unsigned int *adjacency = offset + vertices + 1;    // 3 * triangles
+    unsigned int *live = adjacency + 3 * triangles;     // vertices
+    unsigned int *stamp = live + vertices;              // vertices
+    unsigned int *dead = stamp + vertices;              // 3 * triangles
+    unsigned int *emitted = dead + 3 * triangles;       // triangles
+    unsigned int time = cacheSize + 1;
+    int written = 0, runs = 0, top = 0, cursor = 0, fan = 0;
+
+    // vertex -> triangle adjacency as a counting sort of the corners
+    memset(offset, 0, (vertices + 1) * sizeof(*offset));
+    for (int i = 0; i < 3 * triangles; i++)
+        offset[index[i] + 1]++;
+    for (int i = 0; i < vertices; i++) {
+        live[i] = offset[i + 1];
+        offset[i + 1] += offset[i];
+    }
+    for (int i = 0; i < 3 * triangles; i++)
+        adjacency[offset[index[i]]++] = i / 3;
+    for (int i = vertices; i > 0; i--)
+        offset[i] = offset[i - 1];
+    offset[0] = 0;
+
+    memset(stamp, 0, vertices * sizeof(*stamp));
+    memset(emitted, 0, triangles * sizeof(*emitted));
+
+    while (cursor < vertices && live[cursor] == 0)
+        cursor++;
+    fan = cursor < vertices ? cursor : -1;
+    if (fan >= 0 && clusters)
+        clusters[runs] = 0;
+    runs += fan >= 0;
+
+    while (fan >= 0) {
+        int first = top, next = -1, best = -1;
+
+        // emit every remaining triangle around the fanning vertex
+        for (unsigned int a = offset[fan]; a < offset[fan + 1]; a++) {
+            unsigned int t = adjacency[a];
+            if (emitted[t])
+                continue;
+            for (int c = 0; c < 3; c++) {
+                unsigned int v = index[3 * t + c];
+                dead[top++] = v;
+                live[v]--;
+                if (time - stamp[v] > (unsigned int)cacheSize)
+                    stamp[v] = time++;
+                out[3 * written + c] = v;
+            }
+            emitted[t] = 1;
+            written++;
+        }
+
+        // the next fan is the vertex just touched that will still be
+        // in the cache after its remaining triangles are emitted, and
+        // has been in the cache longest
+        for (int i = first; i < top; i++) {
+            unsigned int v = dead[i];
+            int priority;
+            if (live[v] == 0)
+                continue;
+            priority = 0;
+            if (time - stamp[v] + 2 * live[v] <= (unsigned int)cacheSize)
+                priority = time - stamp[v];
+            if (priority > best) {
+                best = priority;
+                next = v;
+            }
+        }
+
+        if (next < 0) {
+            // dead end: back up through recently used vertices, then
+            // fall back to the first vertex in input order
+            while (top > 0 && next < 0) {
+                unsigned int v = dead[--top];
+                if (live[v] > 0)
+                    next = v;
+            }
+            while (next < 0 && cursor < vertices) {
+                if (live[cursor] > 0)
+                    next = cursor;
+                else
+                    cursor++;
+            }
+            if (next >= 0) {
+                if (clusters)
+                    clusters[runs] = written;
+                runs++;
+            }
+        }
+        fan = next;
+    }
+
+    if (clusters)
+        clusters[runs] = triangles;
+    return runs;
+}
+
+/* 
+ * seMeshClusterSplit:
+ * Subdivides the runs of a cache-optimized index list (as written by
+ * seMeshOptimizeCache) into smaller clusters that seMeshOptimizeOverdraw
+ * can reorder. A run is cut wherever the miss ratio of the cluster so
+ * far drops to threshold times that of the whole run, so each cut costs
+ * little extra vertex work; threshold around 1.05 keeps the ACMR within
+ * a few percent. Writes the cluster starts plus a final entry of
+ * triangles to out (room for triangles + 1) and returns the cluster
+ * count. Scratch must hold vertices unsigned ints.
+ * 
+ * Scratch is cleared once; runs and clusters start cold by advancing
+ * the FIFO clock past cacheSize instead, so the cost stays linear in
+ * triangles however many runs there are.
+ * 
+ */
+int seMeshClusterSplit(const unsigned int *index, int triangles, int vertices, const unsigned int *clusters, int clusterCount, int cacheSize, seFloat threshold, unsigned int *out, unsigned int *scratch)
+{
+    // same FIFO model as seMeshCacheStats, 0 in scratch means never
+    unsigned int time = cacheSize + 1;
+    int count = 0;
+
+    memset(scratch, 0, vertices * sizeof(*scratch));
+    for (int c = 0; c < clusterCount; c++) {
+        int begin = clusters[c], end = clusters[c + 1];
+        int start = begin, local = 0, misses = 0;
+
+        // misses of the whole run, from a cold cache
+        for (int i = 3 * begin; i < 3 * end; i++) {
+            unsigned int v = index[i];
+            if (time - scratch[v] > (unsigned int)cacheSize) {
+                scratch[v] = time++;
+                misses++;
+            }
+        }
+        time += cacheSize + 1;
+
+        seFloat limit = threshold * misses / (end - begin > 0 ? end - begin : 1);
+
+        out[count++] = begin;
+        for (int t = begin; t < end; t++) {
+            for (int k = 0; k < 3; k++) {
+                unsigned int v = index[3 * t + k];
+                if (time - scratch[v] > (unsigned int)cacheSize) {
+                    scratch[v] = time++;
+                    local++;
+                }
+            }
+            // cut after this triangle, starting the next cluster cold
+            if (t + 1 < end && (seFloat)local <= limit * (t + 1 - start)) {
+                out[count++] = t + 1;
+                start = t + 1;
+                local = 0;
+                time += cacheSize + 1;
+            }
+        }
+        time += cacheSize + 1;
+    }
+
+    out[count] = triangles;
+    return count;
+}
+
+/* 
+ * seMeshOptimizeOverdraw:
+ * Reorders the clusters of an index list (cluster starts followed by a
+ * final entry of triangles) to reduce overdraw, keeping the triangle
+ * order inside each cluster so vertex cache locality is preserved, and
+ * writes the result to out, which must not alias index.
+ * 
+ * With no view directions, clusters are sorted by how far they sit out
+ * along their own average normal from the mesh centroid, which draws
+ * the outer, likely occluding surfaces first from any viewpoint (Sander
+ * et al. 2007). Given viewCount viewing directions (the direction each
+ * camera looks along), each cluster is instead scored by how near to
+ * the camera it is in the views it faces, averaged over the views.
+ * Keys needs clusterCount floats and scratch 4 * clusterCount unsigned
+ * ints.
+ * 
+ */
+void seMeshOptimizeOverdraw(const unsigned int *index, int triangles, const seVec3 *v, const unsigned int *clusters, int clusterCount, const seVec3 *views, int viewCount, unsigned int *out, seFloat *keys, unsigned int *scratch)
+{
+    unsigned int *perm = scratch;
+    seVec3 center = seV3Assign(0, 0, 0);
+    seFloat total = 0;
+    int written = 0;
+
+    // area-weighted mesh centroid
+    for (int t = 0; t < triangles; t++) {
+        seVec3 a = v[index[3 * t]], b = v[index[3 * t + 1]], c = v[index[3 * t + 2]];
+        seFloat area = seV3Length(seV3Cross(seV3Subtract(b, a), seV3Subtract(c, a)));
+        center.x += (a.x + b.x + c.x) * area;
+        center.y += (a.y + b.y + c.y) * area;
+        center.z += (a.z + b.z + c.z) * area;
+        total += area;
+    }
+    total = total > 0 ? 1 / (3 * total) : 0;
+    center = seV3Assign(center.x * total, center.y * total, center.z * total);
+
+    for (int c = 0; c < clusterCount; c++) {
+        seVec3 centroid = seV3Assign(0, 0, 0), normal = seV3Assign(0, 0, 0);
+        seFloat area = 0, key = 0;
+
+        for (unsigned int t = clusters[c]; t < clusters[c + 1]; t++) {
+            seVec3 a = v[index[3 * t]], b = v[index[3 * t + 1]], p = v[index[3 * t + 2]];
+            seVec3 n = seV3Cross(seV3Subtract(b, a), seV3Subtract(p, a));
+            seFloat len = seV3Length(n);
+            centroid.x += (a.x + b.x + p.x) * len;
+            centroid.y += (a.y + b.y + p.y) * len;
+            centroid.z += (a.z + b.z + p.z) * len;
+            normal = seV3Add(normal, n);
+            area += len;
+        }
+        area = area > 0 ? 1 / (3 * area) : 0;
+        centroid = seV3Assign(centroid.x * area - center.x, centroid.y * area - center.y, centroid.z * area - center.z);
+
+        if (viewCount > 0) {
+            // clusters facing away are culled in that view and don't count
+            for (int i = 0; i < viewCount; i++)
+                if (seV3Dot(normal, views[i]) < 0)
+                    key -= seV3Dot(centroid, views[i]);
+            key /= viewCount;
+        } else {
+            seFloat len = seV3Length(normal);
+            key = len > 0 ? seV3Dot(centroid, normal) / len : 0;
+        }
+        keys[c] = key;
+    }
+
+    // largest key first
+    seSortDepths(keys, clusterCount, 1, perm, scratch + clusterCount);
+
+    for (int i = 0; i < clusterCount; i++) {
+        unsigned int c = perm[i];
+        int n = 3 * (clusters[c + 1] - clusters[c]);
+        memcpy(out + 3 * written, index + 3 * clusters[c], n * sizeof(*out));
+        written += n / 3;
+    }
+}
+
+/* 
+ * seMeshOptimizeFetch:
+ * Renumbers vertices in the order the index list first references them,
+ * so vertex fetches walk memory forwards, and rewrites the index list
+ * in place. Writes the old to new mapping to remap (vertices entries);
+ * unreferenced vertices are moved to the end. Returns the number of
+ * referenced vertices. Apply remap to each attribute array with
+ * seMeshRemapV3 or seMeshRemap.
+ * 
+ */
+int seMeshOptimizeFetch(unsigned int *index, int triangles, int vertices, unsigned int *remap)
+{
+    unsigned int next = 0;
+    int used;
+
+    memset(remap, 0xff, vertices * sizeof(*remap));
+    for (int i = 0; i < 3 * triangles; i++) {
+        unsigned int v = index[i];
+        if (remap[v] == 0xffffffffu)
+            remap[v] = next++;
+        index[i] = remap[v];
+    }
+
+    used = next;
+    for (int i = 0; i < vertices; i++)
+        if (remap[i] == 0xffffffffu)
+            remap[i] = next++;
+    return used;
+}
+
+/* 
+ * seMeshRemapV3:
+ * Scatters v[i] to out[remap[i]] for vertices entries; out must not
+ * alias v.
+ * 
+ */
+void seMeshRemapV3(const seVec3 *v, const unsigned int *remap, int vertices, seVec3 *out)
+{
+    for (int i = 0; i < vertices; i++)
+        out[remap[i]] = v[i];
+}
+
+/* 
+ * seMeshRemap:
+ * Scatters vertices elements of stride bytes each from in to out by
+ * remap, for attributes of any type; out must not alias in.
+ * 
+ */
+void seMeshRemap(const void *in, const unsigned int *remap, int vertices, int stride, void *out)
+{
+    const unsigned char *src = (const unsigned char *)in;
+    unsigned char *dst = (unsigned char *)out;
+
+    for (int i = 0; i < vertices; i++)
+        memcpy(dst + (size_t)remap[i] * stride, src + (size_t)i * stride, stride);
+}
+
+/* Depth Sorting */
+
+/* 
+ * seV3ViewDepths:
+ * Computes the view-space depth (distance in front of the camera along
+ * its viewing direction) of count points given as SoA streams.
+ * 
+ */
+void seV3ViewDepths(seMat4 view, const seFloat *x, const seFloat *y, const seFloat *z, int count, seFloat *depth)
+{
+    // only the third row matters; view space looks down -z
+    seFloat a = -view.e[8], b = -view.e[9], c = -view.e[10], d = -view.e[11];
+
+    for (int i = 0; i < count; i++)
+        depth[i] = a * x[i] + b * y[i] + c * z[i] + d;
+}
+
+#define SE_SORT_BITS 11
+#define SE_SORT_BUCKETS (1 << SE_SORT_BITS)
+
+/* 
+ * seSortKeys:
+ * Stable LSD radix sort of 32-bit keys, in place, writing the original
+ * index of each sorted key to perm. Scratch must hold 2 * count
+ * unsigned ints; nothing is allocated.
+ * 
+ * All three 11-bit histograms are built in a single read of the keys,
+ * and passes whose digit is the same for every key (common when keys
+ * span a narrow range) are skipped. This runs on one thread; for large
+ * counts the same passes can be spread over several with
+ * seSortHistogram, seSortPrefix and seSortScatter.
+ * 
+ */
+void seSortKeys(unsigned int *keys, int count, unsigned int *perm, unsigned int *scratch)
+{
+    unsigned int hist[3][SE_SORT_BUCKETS];
+    unsigned int *keys2 = scratch, *perm2 = scratch + count;
+    unsigned int *outKeys = keys, *outPerm = perm;
+
+    memset(hist, 0, sizeof(hist));
+    for (int i = 0; i < count; i++) {
+        unsigned int k = keys[i];
+        perm[i] = i;
+        hist[0][k & (SE_SORT_BUCKETS - 1)]++;
+        hist[1][(k >> SE_SORT_BITS) & (SE_SORT_BUCKETS - 1)]++;
+        hist[2][k >> (2 * SE_SORT_BITS)]++;
+    }
+
+    for (int pass = 0; pass < 3; pass++) {
+        int shift = pass * SE_SORT_BITS;
+        unsigned int *h = hist[pass];
+        unsigned int sum = 0;
+
+        if (count == 0 || h[(keys[0] >> shift) & (SE_SORT_BUCKETS - 1)] == (unsigned int)count)
+            continue;
+
+        for (int b = 0; b < SE_SORT_BUCKETS; b++) {
+            unsigned int n = h[b];
+            h[b] = sum;
+            sum += n;
+        }
+        seSortScatter(keys, perm, 0, count, pass, h, keys2, perm2);
+
+        unsigned int *t = keys;
+        keys = keys2;
+        keys2 = t;
+        t = perm;
+        perm = perm2;
+        perm2 = t;
+    }
+
+    // an odd number of passes leaves the result in scratch
+    if (perm != outPerm) {
+        memcpy(outPerm, perm, count * sizeof(*perm));
+        memcpy(outKeys, keys, count * sizeof(*keys));
+    }
+}
+
+/* 
+ * seSortHistogram:
+ * Counts the digit of radix pass pass (0 to 2, lowest digit first) of
+ * keys first..last - 1 into hist, SE_SORT_BUCKETS unsigned ints, which
+ * it clears first.
+ * 
+ * With seSortPrefix and seSortScatter this is seSortKeys split into
+ * steps a thread pool can share. Cut the keys into slices (see
+ * seBatchRange); then for each pass, histogram every slice into its
+ * own row of a slices * SE_SORT_BUCKETS table, run seSortPrefix once
+ * on the table, scatter every slice with its row into the other pair
+ * of buffers and swap the pairs. Slices are independent within a step,
+ * so the caller only needs a barrier between steps, and the sort stays
+ * stable however the keys were sliced.
+ * 
+ */
+void seSortHistogram(const unsigned int *keys, int first, int last, int pass, unsigned int *hist)
+{
+    int shift = pass * SE_SORT_BITS;
+
+    memset(hist, 0, SE_SORT_BUCKETS * sizeof(*hist));
+    for (int i = first; i < last; i++)
+        hist[(keys[i] >> shift) & (SE_SORT_BUCKETS - 1)]++;
+}
+
+/* 
+ * seSortPrefix:
+ * Turns the table of slices histograms from seSortHistogram, one row
+ * per slice in key order, into the position at which each slice writes
+ * its first key of each bucket. Returns 0 when every key falls in the
+ * same bucket; the pass can then be skipped, leaving keys and perm
+ * where they are, and the table is left unchanged.
+ * 
+ */
+int seSortPrefix(unsigned int *hist, int slices)
+{
+    unsigned int count = 0, sum = 0;
+
+    for (int i = 0; i < slices * SE_SORT_BUCKETS; i++)
+        count += hist[i];
+
+    // if one bucket holds every key it is the first nonempty one
+    for (int b = 0; b < SE_SORT_BUCKETS; b++) {
+        unsigned int n = 0;
+        for (int s = 0; s < slices; s++)
+            n += hist[s * SE_SORT_BUCKETS + b];
+        if (n == count)
+            return 0;
+        if (n)
+            break;
+    }
+
+    for (int b = 0; b < SE_SORT_BUCKETS; b++) {
+        for (int s = 0; s < slices; s++) {
+            unsigned int n = hist[s * SE_SORT_BUCKETS + b];
+            hist[s * SE_SORT_BUCKETS + b] = sum;
+            sum += n;
+        }
+    }
+    return 1;
+}
+
+/* 
+ * seSortScatter:
+ * Moves keys first..last - 1 to their places for radix pass pass in
+ * outKeys, and their entries of perm to the same places in outPerm,
+ * advancing hist, the slice's row of the table from seSortPrefix. A
+ * NULL perm stands for the keys' own positions, for the first pass
+ * that is not skipped; if every pass is skipped the keys were already
+ * sorted and perm is the identity.
+ * 
+ */
+void seSortScatter(const unsigned int *keys, const unsigned int *perm, int first, int last, int pass, unsigned int *hist, unsigned int *outKeys, unsigned int *outPerm)
+{
+    int shift = pass * SE_SORT_BITS;
+
+    for (int i = first; i < last; i++) {
+        unsigned int k = keys[i];
+        unsigned int o = hist[(k >> shift) & (SE_SORT_BUCKETS - 1)]++;
+        outKeys[o] = k;
+        outPerm[o] = perm ? perm[i] : (unsigned int)i;
+    }
+}
+
+/* 
+ * seSortDepthKeys:
+ * Maps count float depths to unsigned keys that sort front-to-back
+ * (ascending) or, when backToFront is nonzero, back-to-front. Depths
+ * are independent, so a long stream can be mapped in slices alongside
+ * seSortHistogram.
+ * 
+ */
+void seSortDepthKeys(const seFloat *depth, int count, int backToFront, unsigned int *keys)
+{
+    unsigned int flip = backToFront ? 0xffffffffu : 0;
+
+    for (int i = 0; i < count; i++) {
+        unsigned int k;
+        memcpy(&k, &depth[i], sizeof(k));
+        // negative floats reverse their order, positive ones set the sign
+        k ^= (k & 0x80000000u) ? 0xffffffffu : 0x80000000u;
+        keys[i] = k ^ flip;
+    }
+}
+
+/* 
+ * seSortDepths:
+ * Stable sort of float depths, writing the sorted order of the indices
+ * 0..count - 1 to perm: front-to-back (ascending) or, when backToFront
+ * is nonzero, back-to-front. Scratch must hold 3 * count unsigned ints;
+ * nothing is allocated.
+ * 
+ * Floats are mapped to order-preserving unsigned keys with
+ * seSortDepthKeys and sorted with seSortKeys.
+ * 
+ */
+void seSortDepths(const seFloat *depth, int count, int backToFront, unsigned int *perm, unsigned int *scratch)
+{
+    seSortDepthKeys(depth, count, backToFront, scratch);
+    seSortKeys(scratch, count, perm, scratch + count);
+}
+
+/* Spatial Ordering */
+
+/* 
+ * seMorton3:
+ * Interleaves the low 10 bits of x, y and z into a 30-bit Morton
+ * (Z-order) code, x in the lowest bit of each triple.
+ * 
+ */
+unsigned int seMorton3(unsigned int x, unsigned int y, unsigned int z)
+{
+    unsigned int v[3] = { x, y, z };
+
+    for (int i = 0; i < 3; i++) {
+        unsigned int n = v[i] & 0x3ff;
+        n = (n | (n << 16)) & 0x030000ffu;
+        n = (n | (n << 8)) & 0x0300f00fu;
+        n = (n | (n << 4)) & 0x030c30c3u;
+        n = (n | (n << 2)) & 0x09249249u;
+        v[i] = n;
+    }
+    return v[0] | (v[1] << 1) | (v[2] << 2);
+}
+
+/* 
+ * seHilbert3:
+ * Returns the 30-bit index along a 3D Hilbert curve of the cell with
+ * 10-bit coordinates x, y and z. Unlike Morton order, consecutive
+ * indices are always face-adjacent cells. Uses Skilling's transform
+ * (Programming the Hilbert curve, 2004) followed by bit interleaving.
+ * 
+ */
+unsigned int seHilbert3(unsigned int x, unsigned int y, unsigned int z)
+{
+    unsigned int X[3] = { x & 0x3ff, y & 0x3ff, z & 0x3ff };
+    unsigned int t = 0;
+
+    // inverse undo of the excess work
+    for (unsigned int q = 1u << 9; q > 1; q >>= 1) {
+        unsigned int p = q - 1;
+        for (int i = 0; i < 3; i++) {
+            if (X[i] & q) {
+                X[0] ^= p;
+            } else {
+                unsigned int s = (X[0] ^ X[i]) & p;
+                X[0] ^= s;
+                X[i] ^= s;
+            }
+        }
+    }
+
+    // gray encode
+    X[1] ^= X[0];
+    X[2] ^= X[1];
+    for (unsigned int q = 1u << 9; q > 1; q >>= 1)
+        if (X[2] & q)
+            t ^= q - 1;
+    for (int i = 0; i < 3; i++)
+        X[i] ^= t;
+
+    // the first axis holds the most significant bit of each triple
+    return seMorton3(X[2], X[1], X[0]);
+}
+
+/* 
+ * seV3BoundsBatch:
+ * Writes the axis-aligned bounds of count points to lo and hi.
+ * 
+ */
+void seV3BoundsBatch(seVec3s p, int count, seVec3 *lo, seVec3 *hi)
+{
+    seVec3 a = seV3Assign(INFINITY, INFINITY, INFINITY);
+    seVec3 b = seV3Assign(-INFINITY, -INFINITY, -INFINITY);
+
+    for (int i = 0; i < count; i++) {
+        a.x = fminf(a.x, p.x[i]);
+        a.y = fminf(a.y, p.y[i]);
+        a.z = fminf(a.z, p.z[i]);
+        b.x = fmaxf(b.x, p.x[i]);
+        b.y = fmaxf(b.y, p.y[i]);
+        b.z = fmaxf(b.z, p.z[i]);
+    }
+    *lo = a;
+    *hi = b;
+}
+
+/* 
+ * seSpatialKeys:
+ * Quantizes count points to a 1024^3 grid spanning lo to hi and writes
+ * their SE_CURVE_MORTON or SE_CURVE_HILBERT keys. Points are
+ * independent, so large streams can be keyed in slices on several
+ * threads.
+ * 
+ */
+void seSpatialKeys(seVec3s p, seVec3 lo, seVec3 hi, int curve, unsigned int *keys, int count)
+{
+    seFloat sx = hi.x > lo.x ? 1023.0f / (hi.x - lo.x) : 0;
+    seFloat sy = hi.y > lo.y ? 1023.0f / (hi.y - lo.y) : 0;
+    seFloat sz = hi.z > lo.z ? 1023.0f / (hi.z - lo.z) : 0;
+
+    for (int i = 0; i < count; i++) {
+        // clamp so points outside the bounds still get a valid cell
+        unsigned int x = (unsigned int)fminf(fmaxf((p.x[i] - lo.x) * sx, 0), 1023);
+        unsigned int y = (unsigned int)fminf(fmaxf((p.y[i] - lo.y) * sy, 0), 1023);
+        unsigned int z = (unsigned int)fminf(fmaxf((p.z[i] - lo.z) * sz, 0), 1023);
+        keys[i] = curve == SE_CURVE_HILBERT ? seHilbert3(x, y, z) : seMorton3(x, y, z);
+    }
+}
+
+/* 
+ * seSpatialOrder:
+ * Writes to perm the order of count points along a Morton or Hilbert
+ * curve over their bounds: perm[i] is the old index of the point that
+ * goes to position i. Apply it with sePermute. Scratch must hold
+ * 3 * count unsigned ints.
+ * 
+ */
+void seSpatialOrder(seVec3s p, int count, int curve, unsigned int *perm, unsigned int *scratch)
+{
+    seVec3 lo, hi;
+
+    seV3BoundsBatch(p, count, &lo, &hi);
+    seSpatialKeys(p, lo, hi, curve, scratch, count);
+    seSortKeys(scratch, count, perm, scratch + count);
+}
+
+/* 
+ * sePermute:
+ * Reorders streamCount arrays of count elements in place so element i
+ * becomes the old element perm[i]. Each stream has its own element
+ * size in bytes in strides; pass x, y and z separately for a seVec3s.
+ * Cycles of the permutation are followed once for all streams, with
+ * elements swapped bytewise, so no stream is copied. Scratch must hold
+ * (count + 31) / 32 unsigned ints.
+ * 
+ */
+void sePermute(const unsigned int *perm, int count, void *const *streams, const int *strides, int streamCount, unsigned int *scratch)
+{
+    memset(scratch, 0, ((count + 31) / 32) * sizeof(*scratch));
+
+    for (int i = 0; i < count; i++) {
+        unsigned int j = i;
+
+        if (scratch[i >> 5] & (1u << (i & 31)))
+            continue;
+
+        // carry the old element i along the cycle, pulling each
+        // element into place with a swap
+        while (perm[j] != (unsigned int)i) {
+            unsigned int k = perm[j];
+            for (int s = 0; s < streamCount; s++) {
+                unsigned char *a = (unsigned char *)streams[s] + (size_t)j * strides[s];
+                unsigned char *b = (unsigned char *)streams[s] + (size_t)k * strides[s];
+                for (int n = 0; n < strides[s]; n++) {
+                    unsigned char t = a[n];
+                    a[n] = b[n];
+                    b[n] = t;
+                }
+            }
+            scratch[j >> 5] |= 1u << (j & 31);
+            j = k;
+        }
+        scratch[j >> 5] |= 1u << (j & 31);
+    }
+}
+
+/* Cameras */
+
+/* 
+ * seCameraInit:
+ * Sets up a camera at the origin looking down -z with a 60 degree
+ * field of view, and marks all of its derived data stale.
+ * 
+ */
+void seCameraInit(seCamera *cam)
+{
+    memset(cam, 0, sizeof(*cam));
+    cam->viewVersion = 1;
+    cam->projectionVersion = 1;
+    cam->eye = seV3Assign(0, 0, 0);
+    cam->center = seV3Assign(0, 0, -1);
+    cam->up = seV3Assign(0, 1, 0);
+    cam->angle = SE_DEG2RAD(60.0f);
+    cam->ratio = 1;
+    cam->near = 0.1f;
+    cam->far = 1000;
+}
+
+/* 
+ * seCameraLookAt:
+ * Sets the view parameters of a camera, as passed to seM4LookAt.
+ * 
+ */
+void seCameraLookAt(seCamera *cam, seVec3 eye, seVec3 center, seVec3 up)
+{
+    cam->eye = eye;
+    cam->center = center;
+    cam->up = up;
+    cam->viewVersion++;
+}
+
+/* 
+ * seCameraPerspective:
+ * Sets the projection parameters of a camera, as passed to
+ * seM4Perspective.
+ * 
+ */
+void seCameraPerspective(seCamera *cam, seFloat angle, seFloat ratio, seFloat near, seFloat far)
+{
+    cam->angle = angle;
+    cam->ratio = ratio;
+    cam->near = near;
+    cam->far = far;
+    cam->projectionVersion++;
+}
+
+/* 
+ * seCameraStale:
+ * Returns nonzero if a cached item is out of date with respect to the
+ * camera parameters it depends on, and stamps it as current.
+ * 
+ */
+int seCameraStale(seCamera *cam, int item, int view, int projection)
+{
+    unsigned int *stamp = cam->stamp[item];
+    int stale = (view && stamp[0] != cam->viewVersion) ||
+                (projection && stamp[1] != cam->projectionVersion);
+
+    if (stale) {
+        stamp[0] = cam->viewVersion;
+        stamp[1] = cam->projectionVersion;
+    }
+    return stale;
+}
+
+/* 
+ * seCameraView:
+ * Returns the world-to-view matrix of the camera.
+ * 
+ */
+const seMat4 *seCameraView(seCamera *cam)
+{
+    if (seCameraStale(cam, SE_CAMERA_VIEW, 1, 0))
+        cam->view = seM4LookAt(cam->eye, cam->center, cam->up);
+    return &cam->view;
+}
+
+/* 
+ * seCameraProjection:
+ * Returns the view-to-clip matrix of the camera.
+ * 
+ */
+const seMat4 *seCameraProjection(seCamera *cam)
+{
+    if (seCameraStale(cam, SE_CAMERA_PROJECTION, 0, 1))
+        cam->projection = seM4Perspective(cam->angle, cam->ratio, cam->near, cam->far);
+    return &cam->projection;
+}
+
+/* 
+ * seCameraViewProjection:
+ * Returns the world-to-clip matrix of the camera.
+ * 
+ */
+const seMat4 *seCameraViewProjection(seCamera *cam)
+{
+    if (seCameraStale(cam, SE_CAMERA_VIEW_PROJECTION, 1, 1))
+        cam->viewProjection = seM4Multiply(*seCameraProjection(cam), *seCameraView(cam));
+    return &cam->viewProjection;
+}
+
+/* 
+ * seCameraInverseView:
+ * Returns the camera-to-world matrix. The view matrix is rigid, so this
+ * only transposes its rotation and rotates back the translation.
+ * 
+ */
+const seMat4 *seCameraInverseView(seCamera *cam)
+{
+    if (seCameraStale(cam, SE_CAMERA_INVERSE_VIEW, 1, 0)) {
+        seMat4 out = seM4Transpose(*seCameraView(cam));
+        out.e[3]  = cam->eye.x;
+        out.e[7]  = cam->eye.y;
+        out.e[11] = cam->eye.z;
+        out.e[12] = 0;
+        out.e[13] = 0;
+        out.e[14] = 0;
+        cam->inverseView = out;
+    }
+    return &cam->inverseView;
+}
+
+/* 
+ * seCameraInverseProjection:
+ * Returns the clip-to-view matrix, built directly from the projection
+ * parameters.
+ * 
+ */
+const seMat4 *seCameraInverseProjection(seCamera *cam)
+{
+    if (seCameraStale(cam, SE_CAMERA_INVERSE_PROJECTION, 0, 1)) {
+        const seFloat *p = seCameraProjection(cam)->e;
+        seMat4 out = seM4Fill(0);
+        out.e[0]  =  1 / p[0];
+        out.e[5]  =  1 / p[5];
+        out.e[11] = -1;
+        out.e[14] =  1 / p[11];
+        out.e[15] =  p[10] / p[11];
+        cam->inverseProjection = out;
+    }
+    return &cam->inverseProjection;
+}
+
+/* 
+ * seCameraInverseViewProjection:
+ * Returns the clip-to-world matrix of the camera.
+ * 
+ */
+const seMat4 *seCameraInverseViewProjection(seCamera *cam)
+{
+    if (seCameraStale(cam, SE_CAMERA_INVERSE_VIEW_PROJECTION, 1, 1))
+        cam->inverseViewProjection = seM4Multiply(*seCameraInverseView(cam),
+                                                  *seCameraInverseProjection(cam));
+    return &cam->inverseViewProjection;
+}
+
+/* 
+ * seCameraFrustum:
+ * Returns the six world-space clipping planes of the camera, in the
+ * order produced by seM4Frustum.
+ * 
+ */
+const sePlane *seCameraFrustum(seCamera *cam)
+{
+    if (seCameraStale(cam, SE_CAMERA_FRUSTUM, 1, 1))
+        seM4Frustum(*seCameraViewProjection(cam), cam->frustum);
+    return cam->frustum;
+}
+
+/* 
+ * seCameraUpdate:
+ * Rebuilds everything that is stale. Getters rebuild lazily and so
+ * write to the camera; call this once after changing parameters and
+ * before handing the camera to worker threads, after which concurrent
+ * reads through the getters are pure reads.
+ * 
+ */
+void seCameraUpdate(seCamera *cam)
+{
+    seCameraInverseViewProjection(cam);
+    seCameraFrustum(cam);
+}
+
+/* Frustum Culling */
+
+/* 
+ * seSphereVisible:
+ * Returns nonzero unless a sphere lies entirely outside one of six
+ * normalized frustum planes (as from seM4Frustum).
+ * 
+ */
+int seSphereVisible(const sePlane *planes, seVec3 c, seFloat r)
+{
+    for (int p = 0; p < 6; p++)
+        if (seV3Dot(planes[p].n, c) + planes[p].d < -r)
+            return 0;
+    return 1;
+}
+
+/* 
+ * seCullSpheres:
+ * Tests count bounding spheres against six frustum planes and writes a
+ * bitmask (32 per word, least significant first) with a bit set for
+ * every visible sphere, ready for seMaskCompress.
+ * 
+ */
+void seCullSpheres(const sePlane *planes, seVec3s center, const seFloat *radius, unsigned int *visible, int count)
+{
+    memset(visible, 0, ((count + 31) / 32) * sizeof(*visible));
+    for (int i = 0; i < count; i++)
+        if (seSphereVisible(planes, seV3Assign(center.x[i], center.y[i], center.z[i]), radius[i]))
+            visible[i >> 5] |= 1u << (i & 31);
+}
+
+/* 
+ * seCullCacheInit:
+ * Sets up a coherent culling cache for count objects over caller-owned
+ * per-object arrays (plane and expiry, count entries each). Radius must
+ * bound the distance of every object's sphere from the origin; it turns
+ * plane motion into a bound on how far any object's distance to a plane
+ * can have changed. Every object is tested on the first call.
+ * 
+ */
+void seCullCacheInit(seCullCache *cache, signed char *plane, seFloat *expiry, int count, seFloat radius)
+{
+    cache->plane = plane;
+    cache->expiry = expiry;
+    cache->count = count;
+    cache->radius = radius;
+    cache->drift = 0;
+    cache->tested = cache->reused = 0;
+    memset(cache->planes, 0, sizeof(cache->planes));
+    for (int i = 0; i < count; i++) {
+        plane[i] = -1;
+        expiry[i] = -INFINITY;
+    }
+}
+
+/* 
+ * seCullSpheresCoherent:
+ * Same result as seCullSpheres, reusing last frame's work. Each object
+ * keeps the plane that culled it (tested first next time) and the
+ * distance its result had to spare. The spare distance is spent by
+ * camera motion, bounded from how far the planes moved, and by object
+ * motion: moved[i] must bound how far sphere i's surface has moved
+ * since the last call (centre motion plus any radius growth), or moved
+ * is NULL when nothing moved. Objects with distance left keep their
+ * result untested. The cache's tested and reused counts report how the
+ * call went.
+ * 
+ * Once the accumulated drift passes radius it is subtracted from every
+ * expiry and restarts at zero, so the float expiries stay at the scale
+ * of the scene however long the session runs.
+ * 
+ */
+void seCullSpheresCoherent(seCullCache *cache, const sePlane *planes, seVec3s center, const seFloat *radius, const seFloat *moved, unsigned int *visible)
+{
+    signed char *plane = cache->plane;
+    seFloat *expiry = cache->expiry;
+    double limit, step = 0, shift = 0;
+    int tested = 0;
+
+    if (cache->drift > cache->radius) {
+        shift = cache->drift;
+        cache->drift = 0;
+    }
+
+    // the farthest any point within radius of the origin moved relative
+    // to any plane
+    for (int p = 0; p < 6; p++) {
+        seVec3 dn = seV3Subtract(planes[p].n, cache->planes[p].n);
+        double s = seV3Length(dn) * cache->radius + fabsf(planes[p].d - cache->planes[p].d);
+        step = s > step ? s : step;
+        cache->planes[p] = planes[p];
+    }
+    cache->drift += step;
+    // a little slack covers rounding in the stored margins
+    limit = cache->drift + 1e-5 * (cache->radius + cache->drift);
+
+    memset(visible, 0, ((cache->count + 31) / 32) * sizeof(*visible));
+    for (int i = 0; i < cache->count; i++) {
+        seVec3 c;
+        seFloat r, margin = INFINITY;
+        int first, culled = -1;
+
+        // -INFINITY (never tested) stays put
+        if (shift != 0)
+            expiry[i] = (seFloat)(expiry[i] - shift);
+        if (moved)
+            expiry[i] -= moved[i];
+        if (expiry[i] > limit) {
+            if (plane[i] < 0)
+                visible[i >> 5] |= 1u << (i & 31);
+            continue;
+        }
+
+        c = seV3Assign(center.x[i], center.y[i], center.z[i]);
+        r = radius[i];
+        first = plane[i] >= 0 ? plane[i] : 0;
+        for (int k = 0; k < 6; k++) {
+            int p = (first + k) % 6;
+            seFloat s = seV3Dot(planes[p].n, c) + planes[p].d + r;
+            if (s < 0) {
+                culled = p;
+                margin = -s;
+                break;
+            }
+            margin = s < margin ? s : margin;
+        }
+
+        plane[i] = (signed char)culled;
+        expiry[i] = (seFloat)(cache->drift + margin);
+        if (culled < 0)
+            visible[i >> 5] |= 1u << (i & 31);
+        tested++;
+    }
+
+    cache->tested = tested;
+    cache->reused = cache->count - tested;
+}
+
+/* Forward Kinematics */
+
+/* 
+ * seM4DH:
+ * Constructs and returns the transformation matrix of a single
+ * Denavit-Hartenberg link at joint value q, equivalent to
+ * RotZ(theta) * Translate(0, 0, d) * Translate(a, 0, 0) * RotX(alpha).
+ * 
+ */
+seMat4 seM4DH(seDHLink link, seFloat q)
+{
+    seFloat theta = link.theta;
+    seFloat d = link.d;
+    if (link.prismatic)
+        d += q;
+    else
+        theta += q;
+
+    seFloat ct = cosf(SE_DEG2RAD(theta));
+    seFloat st = sinf(SE_DEG2RAD(theta));
+    seFloat ca = cosf(SE_DEG2RAD(link.alpha));
+    seFloat sa = sinf(SE_DEG2RAD(link.alpha));
+
+    seMat4 out;
+    out.e[0]  =  ct;
+    out.e[1]  = -st * ca;
+    out.e[2]  =  st * sa;
+    out.e[3]  =  link.a * ct;
+    out.e[4]  =  st;
+    out.e[5]  =  ct * ca;
+    out.e[6]  = -ct * sa;
+    out.e[7]  =  link.a * st;
+    out.e[8]  =  0;
+    out.e[9]  =  sa;
+    out.e[10] =  ca;
+    out.e[11] =  d;
+    out.e[12] =  0;
+    out.e[13] =  0;
+    out.e[14] =  0;
+    out.e[15] =  1;
+
+    return out;
+}
+
+/* 
+ * seDHForward:
+ * Returns the end-effector transformation of a chain of count links
+ * for a single configuration of joint values.
+ * 
+ */
+seMat4 seDHForward(const seDHLink *links, int count, const seFloat *q)
+{
+    seMat4 out = seM4Identity();
+    for (int i = 0; i < count; i++)
+        out = seM4Multiply(out, seM4DH(links[i], q[i]));
+
+    return out;
+}
+
+#ifndef SE_DH_BLOCK
+#define SE_DH_BLOCK 16
+#endif
+
+/* 
+ * seDHForwardBatch:
+ * Evaluates a chain of count links for many configurations at once.
+ * Joint i of configuration k is read from q[i * stride + k]; the
+ * end-effector transformation of configuration k is written to
+ * effector[k] and, if frames is not NULL, the accumulated transform of
+ * every link to frames[k * count + i].
+ * 
+ * Configurations are processed SE_DH_BLOCK at a time in SoA form so
+ * the per-link work vectorizes across them. To split a large sample set
+ * across threads, give each thread a range by offsetting q, effector
+ * and frames and shrinking configs; stride stays the same.
+ * 
+ */
+void seDHForwardBatch(const seDHLink *links, int count, const seFloat *q, int stride, int configs, seMat4 *effector, seMat4 *frames)
+{
+    // rows 0-2 of an affine transform per configuration in the block
+    seFloat m[12][SE_DH_BLOCK];
+
+    for (int base = 0; base < configs; base += SE_DH_BLOCK) {
+        int n = configs - base < SE_DH_BLOCK ? configs - base : SE_DH_BLOCK;
+
+        for (int r = 0; r < 12; r++)
+            for (int k = 0; k < n; k++)
+                m[r][k] = (r % 5 == 0) ? 1 : 0;
+
+        for (int i = 0; i < count; i++) {
+            seDHLink link = links[i];
+            seFloat ca = cosf(SE_DEG2RAD(link.alpha));
+            seFloat sa = sinf(SE_DEG2RAD(link.alpha));
+            const seFloat *qi = q + i * stride + base;
+
+            for (int k = 0; k < n; k++) {
+                seFloat theta = link.prismatic ? link.theta : link.theta + qi[k];
+                seFloat d = link.prismatic ? link.d + qi[k] : link.d;
+                seFloat ct = cosf(SE_DEG2RAD(theta));
+                seFloat st = sinf(SE_DEG2RAD(theta));
+
+                // link columns; the third row is (0, sa, ca, d)
+                seFloat l0 = ct,  l1 = -st * ca, l2 = st * sa,  l3 = link.a * ct;
+                seFloat l4 = st,  l5 = ct * ca,  l6 = -ct * sa, l7 = link.a * st;
+
+                for (int r = 0; r < 12; r += 4) {
+                    seFloat a0 = m[r][k], a1 = m[r + 1][k], a2 = m[r + 2][k];
+                    m[r][k]     = a0 * l0 + a1 * l4;
+                    m[r + 1][k] = a0 * l1 + a1 * l5 + a2 * sa;
+                    m[r + 2][k] = a0 * l2 + a1 * l6 + a2 * ca;
+                    m[r + 3][k] = a0 * l3 + a1 * l7 + a2 * d + m[r + 3][k];
+                }
+            }
+
+            if (frames) {
+                for (int k = 0; k < n; k++) {
+                    seFloat *e = frames[(base + k) * count + i].e;
+                    for (int r = 0; r < 12; r++)
+                        e[r] = m[r][k];
+                    e[12] = 0;
+                    e[13] = 0;
+                    e[14] = 0;
+                    e[15] = 1;
+                }
+            }
+        }
+
+        for (int k = 0; k < n; k++) {
+            seFloat *e = effector[base + k].e;
+            for (int r = 0; r < 12; r++)
+                e[r] = m[r][k];
+            e[12] = 0;
+            e[13] = 0;
+            e[14] = 0;
+            e[15] = 1;
+        }
+    }
+}
+
+/* Light Clusters */
+
+/* 
+ * seClusterBounds:
+ * Computes the view-space bounding box of a single cluster. View space
+ * looks down -z, as produced by seM4LookAt.
+ * 
+ */
+void seClusterBounds(const seClusterGrid *g, int x, int y, int z, seVec3 *min, seVec3 *max)
+{
+    seFloat ty = tanf(g->angle / 2.0f);
+    seFloat tx = ty * g->ratio;
+    seFloat zn = g->near * powf(g->far / g->near, (seFloat)z / g->depth);
+    seFloat zf = g->near * powf(g->far / g->near, (seFloat)(z + 1) / g->depth);
+    seFloat x0 = -1 + 2 * (seFloat)x / g->width;
+    seFloat x1 = -1 + 2 * (seFloat)(x + 1) / g->width;
+    seFloat y0 = -1 + 2 * (seFloat)y / g->height;
+    seFloat y1 = -1 + 2 * (seFloat)(y + 1) / g->height;
+
+    // the tile widens with distance, so each extreme lies on one plane
+    min->x = (x0 < 0 ? x0 * zf : x0 * zn) * tx;
+    max->x = (x1 > 0 ? x1 * zf : x1 * zn) * tx;
+    min->y = (y0 < 0 ? y0 * zf : y0 * zn) * ty;
+    max->y = (y1 > 0 ? y1 * zf : y1 * zn) * ty;
+    min->z = -zf;
+    max->z = -zn;
+}
+
+/* 
+ * seClusterSpheres:
+ * Transforms lights into view space as bounding spheres, written as
+ * four streams of lights->count floats (x, y, z, radius). Spot lights
+ * are replaced by the smallest sphere around their cone.
+ * 
+ */
+void seClusterSpheres(const seClusterGrid *g, const seLights *lights, seFloat *spheres)
+{
+    int n = lights->count;
+    const seFloat *v = g->view.e;
+
+    for (int i = 0; i < n; i++) {
+        seFloat x = lights->x[i], y = lights->y[i], z = lights->z[i];
+        seFloat r = lights->radius[i];
+
+        if (lights->dx && lights->angle[i] < 90) {
+            seFloat a = SE_DEG2RAD(lights->angle[i]);
+            seFloat ca = cosf(a);
+            seFloat off = (ca < 0.70710678f) ? r * ca : r / (2 * ca);
+            seVec3 d = seV3Normalize(seV3Assign(lights->dx[i], lights->dy[i], lights->dz[i]));
+            x += d.x * off;
+            y += d.y * off;
+            z += d.z * off;
+            r = (ca < 0.70710678f) ? r * sinf(a) : off;
+        }
+
+        spheres[i]         = v[0] * x + v[1] * y + v[2]  * z + v[3];
+        spheres[n + i]     = v[4] * x + v[5] * y + v[6]  * z + v[7];
+        spheres[2 * n + i] = v[8] * x + v[9] * y + v[10] * z + v[11];
+        spheres[3 * n + i] = r;
+    }
+}
+
+/* 
+ * seClusterAssign:
+ * Tests view-space light spheres against every cluster in depth slices
+ * first to last - 1. The grid holds an (offset, count) pair of unsigned
+ * ints per cluster, indexed (z * height + y) * width + x.
+ * 
+ * With indices NULL, only the counts are written; after
+ * seClusterOffsets has filled in the offsets, a second call with
+ * indices writes each cluster's light indices at its offset. Slices are
+ * independent, so threads can each take a range of them in both passes.
+ * 
+ */
+void seClusterAssign(const seClusterGrid *g, const seFloat *spheres, int lights, int first, int last, unsigned int *grid, unsigned int *indices)
+{
+    const seFloat *sx = spheres, *sy = sx + lights, *sz = sy + lights, *sr = sz + lights;
+
+    for (int z = first; z < last; z++) {
+        for (int y = 0; y < g->height; y++) {
+            for (int x = 0; x < g->width; x++) {
+                unsigned int c = (z * g->height + y) * g->width + x;
+                unsigned int count = 0;
+                seVec3 lo, hi;
+                seClusterBounds(g, x, y, z, &lo, &hi);
+
+                for (int i = 0; i < lights; i++) {
+                    // squared distance from the sphere center to the box
+                    seFloat dx = fmaxf(fmaxf(lo.x - sx[i], sx[i] - hi.x), 0);
+                    seFloat dy = fmaxf(fmaxf(lo.y - sy[i], sy[i] - hi.y), 0);
+                    seFloat dz = fmaxf(fmaxf(lo.z - sz[i], sz[i] - hi.z), 0);
+                    int hit = (dx * dx + dy * dy + dz * dz) <= sr[i] * sr[i];
+
+                    if (indices) {
+                        if (hit)
+                            indices[grid[2 * c] + count] = i;
+                    }
+                    count += hit;
+                }
+
+                if (!indices)
+                    grid[2 * c + 1] = count;
+            }
+        }
+    }
+}
+
+/* 
+ * seClusterOffsets:
+ * Fills in the offset of every cluster in the grid from the counts
+ * written by seClusterAssign, and returns the total number of indices.
+ * 
+ */
+unsigned int seClusterOffsets(const seClusterGrid *g, unsigned int *grid)
+{
+    unsigned int total = 0;
+    int clusters = g->width * g->height * g->depth;
+
+    for (int c = 0; c < clusters; c++) {
+        grid[2 * c] = total;
+        total += grid[2 * c + 1];
+    }
+
+    return total;
+}
+
+/* Inverse Kinematics */
+
+/* 
+ * seIKScratchSize:
+ * Returns the number of seFloats of scratch memory the IK solvers need
+ * for a batch of the given shape. The solvers never allocate; callers
+ * can keep one scratch block per thread and reuse it every frame.
+ * 
+ * The first 7 * joints * count floats hold world joint positions (x,
+ * y, z) followed by world rotations (x, y, z, w), each a joint-major
+ * stream indexed [j * count + c].
+ * 
+ */
+int seIKScratchSize(int count, int joints)
+{
+    return (10 * joints + 10) * count;
+}
+
+/* 
+ * seIKForward:
+ * Computes world joint positions and rotations into scratch for every
+ * joint from the specified one down to the end effector. Joints above
+ * first must already be up to date.
+ * 
+ */
+void seIKForward(const seIKChains *ik, seFloat *scratch, int first)
+{
+    int n = ik->count;
+    int size = ik->joints * n;
+    seFloat *px = scratch, *py = px + size, *pz = py + size;
+    seFloat *wx = pz + size, *wy = wx + size, *wz = wy + size, *ww = wz + size;
+
+    for (int j = first; j < ik->joints; j++) {
+        for (int c = 0; c < n; c++) {
+            int k = j * n + c;
+            int l = j * ik->stride + c;
+            seQuat parent;
+            seVec3 p;
+
+            if (j == 0) {
+                parent = seQAssign(ik->rootQX[c], ik->rootQY[c],
+                                   ik->rootQZ[c], ik->rootQW[c]);
+                p = seV3Assign(ik->rootX[c], ik->rootY[c], ik->rootZ[c]);
+            } else {
+                parent = seQAssign(wx[k - n], wy[k - n], wz[k - n], ww[k - n]);
+                p = seV3RotateQ(parent, seV3Assign(ik->ox[l], ik->oy[l], ik->oz[l]));
+                p.x += px[k - n];
+                p.y += py[k - n];
+                p.z += pz[k - n];
+            }
+
+            seQuat w = seQMultiply(parent,
+                seQAssign(ik->qx[l], ik->qy[l], ik->qz[l], ik->qw[l]));
+
+            px[k] = p.x;
+            py[k] = p.y;
+            pz[k] = p.z;
+            wx[k] = w.x;
+            wy[k] = w.y;
+            wz[k] = w.z;
+            ww[k] = w.w;
+        }
+    }
+}
+
+/* 
+ * seIKConverge:
+ * Marks chains whose end effector is within tolerance of the target as
+ * inactive and returns the number of chains still active. Expects the
+ * world positions in scratch to be current.
+ * 
+ */
+int seIKConverge(const seIKChains *ik, seFloat *scratch, seFloat tolerance)
+{
+    int n = ik->count;
+    int e = (ik->joints - 1) * n;
+    seFloat *px = scratch, *py = px + ik->joints * n, *pz = py + ik->joints * n;
+    seFloat *active = scratch + 10 * ik->joints * n;
+    int left = 0;
+
+    for (int c = 0; c < n; c++) {
+        seFloat dx = ik->targetX[c] - px[e + c];
+        seFloat dy = ik->targetY[c] - py[e + c];
+        seFloat dz = ik->targetZ[c] - pz[e + c];
+        active[c] = (dx * dx + dy * dy + dz * dz) > tolerance * tolerance;
+        left += active[c] != 0;
+    }
+
+    return left;
+}
+
+/* 
+ * seIKApply:
+ * Turns joint j of chain c by a world-space rotation and stores the
+ * result as its new (limited) local rotation. Uses the parent world
+ * rotation held in scratch.
+ * 
+ */
+void seIKApply(seIKChains *ik, const seFloat *scratch, int j, int c, seQuat turn)
+{
+    int n = ik->count;
+    int size = ik->joints * n;
+    const seFloat *wx = scratch + 3 * size, *wy = wx + size, *wz = wy + size, *ww = wz + size;
+    int k = (j - 1) * n + c;
+    int l = j * ik->stride + c;
+    seQuat parent;
+
+    if (j == 0)
+        parent = seQAssign(ik->rootQX[c], ik->rootQY[c], ik->rootQZ[c], ik->rootQW[c]);
+    else
+        parent = seQAssign(wx[k], wy[k], wz[k], ww[k]);
+
+    seQuat q = seQAssign(ik->qx[l], ik->qy[l], ik->qz[l], ik->qw[l]);
+    q = seQMultiply(seQConjugate(parent), seQMultiply(turn, seQMultiply(parent, q)));
+    if (ik->limit)
+        q = seQClampAngle(q, ik->limit[j]);
+    q = seQNormalize(q);
+
+    ik->qx[l] = q.x;
+    ik->qy[l] = q.y;
+    ik->qz[l] = q.z;
+    ik->qw[l] = q.w;
+}
+
+/* 
+ * seIKSolveCCD:
+ * Solves a batch of chains with cyclic coordinate descent, turning each
+ * joint from the effector inwards to point the effector at the target.
+ * Stops after the given number of iterations or once every chain is
+ * within tolerance, and returns the number of iterations run.
+ * 
+ */
+int seIKSolveCCD(seIKChains *ik, seFloat *scratch, int iterations, seFloat tolerance)
+{
+    int n = ik->count;
+    int size = ik->joints * n;
+    int e = (ik->joints - 1) * n;
+    seFloat *px = scratch, *py = px + size, *pz = py + size;
+    seFloat *active = scratch + 10 * size;
+    int i;
+
+    seIKForward(ik, scratch, 0);
+    for (i = 0; i < iterations; i++) {
+        if (!seIKConverge(ik, scratch, tolerance))
+            break;
+
+        for (int j = ik->joints - 2; j >= 0; j--) {
+            for (int c = 0; c < n; c++) {
+                if (!active[c])
+                    continue;
+
+                int k = j * n + c;
+                seVec3 a = seV3Assign(px[e + c] - px[k], py[e + c] - py[k], pz[e + c] - pz[k]);
+                seVec3 b = seV3Assign(ik->targetX[c] - px[k], ik->targetY[c] - py[k],
+                                      ik->targetZ[c] - pz[k]);
+                if (seV3Dot(a, a) < 1e-12f || seV3Dot(b, b) < 1e-12f)
+                    continue;
+
+                seIKApply(ik, scratch, j, c, seQFromTo(a, b));
+            }
+            seIKForward(ik, scratch, j);
+        }
+    }
+
+    return i;
+}
+
+/* 
+ * seIKSolveFABRIK:
+ * Solves a batch of chains with forward and backward reaching, then
+ * converts the reached joint positions back into limited local
+ * rotations on every iteration. Returns the number of iterations run.
+ * 
+ */
+int seIKSolveFABRIK(seIKChains *ik, seFloat *scratch, int iterations, seFloat tolerance)
+{
+    int n = ik->count;
+    int size = ik->joints * n;
+    int last = ik->joints - 1;
+    seFloat *px = scratch, *py = px + size, *pz = py + size;
+    seFloat *rx = scratch + 7 * size, *ry = rx + size, *rz = ry + size;
+    seFloat *active = scratch + 10 * size;
+    int i;
+
+    seIKForward(ik, scratch, 0);
+    for (i = 0; i < iterations; i++) {
+        if (!seIKConverge(ik, scratch, tolerance))
+            break;
+
+        // backward: pin the effector to the target and reach for the root
+        for (int c = 0; c < n; c++) {
+            rx[last * n + c] = ik->targetX[c];
+            ry[last * n + c] = ik->targetY[c];
+            rz[last * n + c] = ik->targetZ[c];
+        }
+        for (int j = last - 1; j >= 0; j--) {
+            for (int c = 0; c < n; c++) {
+                int k = j * n + c;
+                int l = (j + 1) * ik->stride + c;
+                seVec3 o = seV3Assign(ik->ox[l], ik->oy[l], ik->oz[l]);
+                seVec3 d = seV3Assign(px[k] - rx[k + n], py[k] - ry[k + n], pz[k] - rz[k + n]);
+                seVec3 bone = seV3Assign(px[k] - px[k + n], py[k] - py[k + n], pz[k] - pz[k + n]);
+                seFloat len = seV3Dot(d, d);
+                int ok = len > 1e-12f;
+                seFloat s = ok ? sqrtf(seV3Dot(o, o) / len) : 0;
+
+                // a reached joint on top of its neighbour has no direction;
+                // keep the bone as it is posed rather than normalize zero
+                rx[k] = rx[k + n] + (ok ? d.x * s : bone.x);
+                ry[k] = ry[k + n] + (ok ? d.y * s : bone.y);
+                rz[k] = rz[k + n] + (ok ? d.z * s : bone.z);
+            }
+        }
+
+        // forward: pin the root back and reach for the effector
+        for (int c = 0; c < n; c++) {
+            rx[c] = px[c];
+            ry[c] = py[c];
+            rz[c] = pz[c];
+        }
+        for (int j = 1; j <= last; j++) {
+            for (int c = 0; c < n; c++) {
+                int k = j * n + c;
+                int l = j * ik->stride + c;
+                seVec3 o = seV3Assign(ik->ox[l], ik->oy[l], ik->oz[l]);
+                seVec3 d = seV3Assign(rx[k] - rx[k - n], ry[k] - ry[k - n], rz[k] - rz[k - n]);
+                seVec3 bone = seV3Assign(px[k] - px[k - n], py[k] - py[k - n], pz[k] - pz[k - n]);
+                seFloat len = seV3Dot(d, d);
+                int ok = len > 1e-12f;
+                seFloat s = ok ? sqrtf(seV3Dot(o, o) / len) : 0;
+
+                rx[k] = rx[k - n] + (ok ? d.x * s : bone.x);
+                ry[k] = ry[k - n] + (ok ? d.y * s : bone.y);
+                rz[k] = rz[k - n] + (ok ? d.z * s : bone.z);
+            }
+        }
+
+        // turn each bone onto its reached direction, parents first
+        for (int j = 0; j < last; j++) {
+            for (int c = 0; c < n; c++) {
+                if (!active[c])
+                    continue;
+
+                int k = j * n + c;
+                seVec3 a = seV3Assign(px[k + n] - px[k], py[k + n] - py[k], pz[k + n] - pz[k]);
+                seVec3 b = seV3Assign(rx[k + n] - px[k], ry[k + n] - py[k], rz[k + n] - pz[k]);
+                // written to also skip NaN directions, which fail every compare
+                if (!(seV3Dot(a, a) >= 1e-12f && seV3Dot(b, b) >= 1e-12f))
+                    continue;
+
+                seIKApply(ik, scratch, j, c, seQFromTo(a, b));
+            }
+            seIKForward(ik, scratch, j);
+        }
+    }
+
+    return i;
+}
+
+/* 
+ * seIKSolveDLS:
+ * Solves a batch of chains with the damped least squares Jacobian
+ * method, treating every joint as a free 3-axis rotation. Larger
+ * damping trades convergence speed for stability near singular poses.
+ * Returns the number of iterations run.
+ * 
+ */
+int seIKSolveDLS(seIKChains *ik, seFloat *scratch, int iterations, seFloat tolerance, seFloat damping)
+{
+    int n = ik->count;
+    int size = ik->joints * n;
+    int e = (ik->joints - 1) * n;
+    seFloat *px = scratch, *py = px + size, *pz = py + size;
+    seFloat *active = scratch + 10 * size;
+    seFloat *a = active + n;    // symmetric 3x3 per chain: xx, xy, xz, yy, yz, zz
+    seFloat *f = a + 6 * n;     // solved task-space force per chain
+    int i;
+
+    seIKForward(ik, scratch, 0);
+    for (i = 0; i < iterations; i++) {
+        if (!seIKConverge(ik, scratch, tolerance))
+            break;
+
+        // JJ^T summed over joints: |r|^2 I - rr^T for each 3-axis joint
+        for (int c = 0; c < n; c++) {
+            a[c] = a[3 * n + c] = a[5 * n + c] = SE_SQUARED(damping);
+            a[n + c] = a[2 * n + c] = a[4 * n + c] = 0;
+        }
+        for (int j = 0; j < ik->joints - 1; j++) {
+            for (int c = 0; c < n; c++) {
+                int k = j * n + c;
+                seFloat x = px[e + c] - px[k];
+                seFloat y = py[e + c] - py[k];
+                seFloat z = pz[e + c] - pz[k];
+                a[c]         += y * y + z * z;
+                a[n + c]     -= x * y;
+                a[2 * n + c] -= x * z;
+                a[3 * n + c] += x * x + z * z;
+                a[4 * n + c] -= y * z;
+                a[5 * n + c] += x * x + y * y;
+            }
+        }
+
+        // f = (JJ^T + damping^2 I)^-1 * error
+        for (int c = 0; c < n; c++) {
+            seFloat xx = a[c], xy = a[n + c], xz = a[2 * n + c];
+            seFloat yy = a[3 * n + c], yz = a[4 * n + c], zz = a[5 * n + c];
+            seFloat ex = ik->targetX[c] - px[e + c];
+            seFloat ey = ik->targetY[c] - py[e + c];
+            seFloat ez = ik->targetZ[c] - pz[e + c];
+            seFloat c0 = yy * zz - yz * yz;
+            seFloat c1 = xz * yz - xy * zz;
+            seFloat c2 = xy * yz - xz * yy;
+            seFloat c4 = xx * zz - xz * xz;
+            seFloat c5 = xy * xz - xx * yz;
+            seFloat c8 = xx * yy - xy * xy;
+            seFloat det = xx * c0 + xy * c1 + xz * c2;
+            seFloat inv = (det != 0) ? 1 / det : 0;
+            f[c]         = (c0 * ex + c1 * ey + c2 * ez) * inv;
+            f[n + c]     = (c1 * ex + c4 * ey + c5 * ez) * inv;
+            f[2 * n + c] = (c2 * ex + c5 * ey + c8 * ez) * inv;
+        }
+
+        // each joint turns about r x f, all against the same starting pose
+        for (int j = 0; j < ik->joints - 1; j++) {
+            for (int c = 0; c < n; c++) {
+                if (!active[c])
+                    continue;
+
+                int k = j * n + c;
+                seVec3 r = seV3Assign(px[e + c] - px[k], py[e + c] - py[k], pz[e + c] - pz[k]);
+                seVec3 w = seV3Cross(r, seV3Assign(f[c], f[n + c], f[2 * n + c]));
+                seFloat t = seV3Length(w);
+                if (t < 1e-9f)
+                    continue;
+
+                seFloat s = sinf(t * 0.5f) / t;
+                seIKApply(ik, scratch, j, c, seQAssign(w.x * s, w.y * s, w.z * s, cosf(t * 0.5f)));
+            }
+        }
+        seIKForward(ik, scratch, 0);
+    }
+
+    return i;
+}
+
+/* Call Tracing */
+
+/* 
+ * seTraceArgs:
+ * Returns the number of seFloat arguments recorded for a SE_TRACE_*
+ * call, or -1 if op is not a traced call.
+ * 
+ */
+int seTraceArgs(int op)
+{
+    switch (op) {
+    case SE_TRACE_V3NORMALIZE:      return 3;
+    case SE_TRACE_V3CROSS:          return 6;
+    case SE_TRACE_V3TRANSFORMM4:    return 19;
+    case SE_TRACE_M4MULTIPLY:       return 32;
+    case SE_TRACE_M4PERSPECTIVE:    return 4;
+    case SE_TRACE_M4LOOKAT:         return 9;
+    case SE_TRACE_M4INVERSE:        return 16;
+    case SE_TRACE_QMULTIPLY:        return 8;
+    case SE_TRACE_QSLERP:           return 9;
+    case SE_TRACE_M4FROMQ:          return 4;
+    default:                        return -1;
+    }
+}
+
+/* 
+ * seTraceRecord:
+ * Appends one call to a trace: an opcode byte followed by its seFloat
+ * arguments, unaligned. Calls that don't fit are counted in dropped
+ * rather than recorded. Does nothing if t is NULL.
+ * 
+ */
+void seTraceRecord(seTrace *t, int op, const seFloat *args)
+{
+    size_t bytes = seTraceArgs(op) * sizeof(seFloat);
+
+    if (!t)
+        return;
+    if (t->used + 1 + bytes > t->size) {
+        t->dropped++;
+        return;
+    }
+    t->data[t->used] = (unsigned char)op;
+    memcpy(t->data + t->used + 1, args, bytes);
+    t->used += 1 + bytes;
+}
+
+/* 
+ * seTraceV3Normalize:
+ * Records and performs seV3Normalize. The other seTrace* wrappers below
+ * do the same for the call they are named after.
+ * 
+ */
+seVec3 seTraceV3Normalize(seTrace *t, seVec3 v)
+{
+    seFloat a[3] = { v.x, v.y, v.z };
+
+    seTraceRecord(t, SE_TRACE_V3NORMALIZE, a);
+    return seV3Normalize(v);
+}
+
+seVec3 seTraceV3Cross(seTrace *t, seVec3 v1, seVec3 v2)
+{
+    seFloat a[6] = { v1.x, v1.y, v1.z, v2.x, v2.y, v2.z };
+
+    seTraceRecord(t, SE_TRACE_V3CROSS, a);
+    return seV3Cross(v1, v2);
+}
+
+seVec3 seTraceV3TransformM4(seTrace *t, seMat4 m, seVec3 v)
+{
+    seFloat a[19];
+
+    memcpy(a, m.e, sizeof(m.e));
+    a[16] = v.x;
+    a[17] = v.y;
+    a[18] = v.z;
+    seTraceRecord(t, SE_TRACE_V3TRANSFORMM4, a);
+    return seV3TransformM4(m, v);
+}
+
+seMat4 seTraceM4Multiply(seTrace *t, seMat4 m1, seMat4 m2)
+{
+    seFloat a[32];
+
+    memcpy(a, m1.e, sizeof(m1.e));
+    memcpy(a + 16, m2.e, sizeof(m2.e));
+    seTraceRecord(t, SE_TRACE_M4MULTIPLY, a);
+    return seM4Multiply(m1, m2);
+}
+
+seMat4 seTraceM4Perspective(seTrace *t, seFloat angle, seFloat ratio, seFloat near, seFloat far)
+{
+    seFloat a[4] = { angle, ratio, near, far };
+
+    seTraceRecord(t, SE_TRACE_M4PERSPECTIVE, a);
+    return seM4Perspective(angle, ratio, near, far);
+}
+
+seMat4 seTraceM4LookAt(seTrace *t, seVec3 eye, seVec3 center, seVec3 up)
+{
+    seFloat a[9] = { eye.x, eye.y, eye.z, center.x, center.y, center.z, up.x, up.y, up.z };
+
+    seTraceRecord(t, SE_TRACE_M4LOOKAT, a);
+    return seM4LookAt(eye, center, up);
+}
+
+seMat4 seTraceM4Inverse(seTrace *t, seMat4 m)
+{
+    seTraceRecord(t, SE_TRACE_M4INVERSE, m.e);
+    return seM4Inverse(m);
+}
+
+seQuat seTraceQMultiply(seTrace *t, seQuat q1, seQuat q2)
+{
+    seFloat a[8] = { q1.x, q1.y, q1.z, q1.w, q2.x, q2.y, q2.z, q2.w };
+
+    seTraceRecord(t, SE_TRACE_QMULTIPLY, a);
+    return seQMultiply(q1, q2);
+}
+
+seQuat seTraceQSlerp(seTrace *t, seQuat q1, seQuat q2, const seFloat s)
+{
+    seFloat a[9] = { q1.x, q1.y, q1.z, q1.w, q2.x, q2.y, q2.z, q2.w, s };
+
+    seTraceRecord(t, SE_TRACE_QSLERP, a);
+    return seQSlerp(q1, q2, s);
+}
+
+seMat4 seTraceM4FromQ(seTrace *t, seQuat q)
+{
+    seFloat a[4] = { q.x, q.y, q.z, q.w };
+
+    seTraceRecord(t, SE_TRACE_M4FROMQ, a);
+    return seM4FromQ(q);
+}
+
+/* 
+ * seTraceReplay:
+ * Runs every call in a recorded trace against this build of the library
+ * and returns the sum of all their results, which keeps the calls from
+ * being optimized away and lets two builds be checked for agreement.
+ * Writes the number of calls replayed to calls if not NULL; replay
+ * stops at the first malformed record. Time it to compare builds on a
+ * production-shaped workload.
+ * 
+ */
+seFloat seTraceReplay(const unsigned char *data, size_t size, int *calls)
+{
+    seFloat sum = 0;
+    size_t pos = 0;
+    int n = 0;
+
+    while (pos < size) {
+        int op = data[pos];
+        int len = seTraceArgs(op);
+        seFloat a[32];
+        seMat4 m1, m2;
+        seVec3 v;
+        seQuat q;
+
+        if (len < 0 || pos + 1 + len * sizeof(seFloat) > size)
+            break;
+        memcpy(a, data + pos + 1, len * sizeof(seFloat));
+        pos += 1 + len * sizeof(seFloat);
+        n++;
+
+        m1 = seM4Fill(0);
+        v = seV3Assign(0, 0, 0);
+        q = seQAssign(0, 0, 0, 0);
+        switch (op) {
+        case SE_TRACE_V3NORMALIZE:
+            v = seV3Normalize(seV3Assign(a[0], a[1], a[2]));
+            break;
+        case SE_TRACE_V3CROSS:
+            v = seV3Cross(seV3Assign(a[0], a[1], a[2]), seV3Assign(a[3], a[4], a[5]));
+            break;
+        case SE_TRACE_V3TRANSFORMM4:
+            memcpy(m2.e, a, sizeof(m2.e));
+            v = seV3TransformM4(m2, seV3Assign(a[16], a[17], a[18]));
+            break;
+        case SE_TRACE_M4MULTIPLY:
+            memcpy(m1.e, a, sizeof(m1.e));
+            memcpy(m2.e, a + 16, sizeof(m2.e));
+            m1 = seM4Multiply(m1, m2);
+            break;
+        case SE_TRACE_M4PERSPECTIVE:
+            m1 = seM4Perspective(a[0], a[1], a[2], a[3]);
+            break;
+        case SE_TRACE_M4LOOKAT:
+            m1 = seM4LookAt(seV3Assign(a[0], a[1], a[2]), seV3Assign(a[3], a[4], a[5]), seV3Assign(a[6], a[7], a[8]));
+            break;
+        case SE_TRACE_M4INVERSE:
+            memcpy(m2.e, a, sizeof(m2.e));
+            m1 = seM4Inverse(m2);
+            break;
+        case SE_TRACE_QMULTIPLY:
+            q = seQMultiply(seQAssign(a[0], a[1], a[2], a[3]), seQAssign(a[4], a[5], a[6], a[7]));
+            break;
+        case SE_TRACE_QSLERP:
+            q = seQSlerp(seQAssign(a[0], a[1], a[2], a[3]), seQAssign(a[4], a[5], a[6], a[7]), a[8]);
+            break;
+        case SE_TRACE_M4FROMQ:
+            m1 = seM4FromQ(seQAssign(a[0], a[1], a[2], a[3]));
+            break;
+        }
+
+        for (int i = 0; i < 16; i++)
+            sum += m1.e[i];
+        sum += v.x + v.y + v.z + q.x + q.y + q.z + q.w;
+    }
+
+    if (calls)
+        *calls = n;
+    return sum;
+}
+
+#ifdef SE_TRACE
+/* 
+ * seTraceActive:
+ * With SE_TRACE defined, the calls below made by code that includes
+ * this header are redirected through their seTrace* wrappers and
+ * recorded to the trace this points at, if any. Calls the library makes
+ * internally are not recorded.
+ * 
+ */
+seTrace *seTraceActive = NULL;
+
+#define seV3Normalize(v) seTraceV3Normalize(seTraceActive, v)
+#define seV3Cross(v1, v2) seTraceV3Cross(seTraceActive, v1, v2)
+#define seV3TransformM4(m, v) seTraceV3TransformM4(seTraceActive, m, v)
+#define seM4Multiply(m1, m2) seTraceM4Multiply(seTraceActive, m1, m2)
+#define seM4Perspective(angle, ratio, near, far) seTraceM4Perspective(seTraceActive, angle, ratio, near, far)
+#define seM4LookAt(eye, center, up) seTraceM4LookAt(seTraceActive, eye, center, up)
+#define seM4Inverse(m) seTraceM4Inverse(seTraceActive, m)
+#define seQMultiply(q1, q2) seTraceQMultiply(seTraceActive, q1, q2)
+#define seQSlerp(q1, q2, t) seTraceQSlerp(seTraceActive, q1, q2, t)
+#define seM4FromQ(q) seTraceM4FromQ(seTraceActive, q)
+#endif
+
 #ifdef __cplusplus
 }
 #endif